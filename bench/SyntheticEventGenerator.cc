@@ -0,0 +1,235 @@
+#include "SyntheticEventGenerator.h"
+#include <IMPL/LCCollectionVec.h>
+#include <IMPL/MCParticleImpl.h>
+#include <IMPL/ParticleIDImpl.h>
+#include <IMPL/ReconstructedParticleImpl.h>
+#include <IMPL/TrackImpl.h>
+#include <UTIL/LCRelationNavigator.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace lcio ;
+
+namespace
+{
+	ParticleIDImpl *makeParticleID( int type , int pdg )
+	{
+		ParticleIDImpl *particleID = new ParticleIDImpl;
+		particleID->setType( type );
+		particleID->setPDG( pdg );
+		particleID->setLikelihood( 1.0 );
+		return particleID;
+	}
+
+	void setFourMomentum( ReconstructedParticleImpl *particle , const double *p4 )
+	{
+		particle->setMomentum( p4 );
+		particle->setEnergy( p4[ 3 ] );
+		particle->setMass( std::sqrt( std::max( p4[ 3 ] * p4[ 3 ] - p4[ 0 ] * p4[ 0 ] - p4[ 1 ] * p4[ 1 ] - p4[ 2 ] * p4[ 2 ] , 0.0 ) ) );
+	}
+}
+
+SyntheticEventGenerator::SyntheticEventGenerator( const Settings &settings ) :
+m_settings( settings ),
+m_generator( settings.seed )
+{
+}
+
+IMPL::LCEventImpl *SyntheticEventGenerator::generate( int run , int event )
+{
+	std::uniform_real_distribution<double> uniform( 0.0 , 1.0 );
+	std::normal_distribution<double> spread( 0.0 , 0.15 );
+	std::normal_distribution<double> smearing( 0.0 , 0.02 );
+	std::exponential_distribution<double> energyFraction( 1.0 );
+	const double eB = m_settings.bField * 2.99792458e8 * 1e-3 * 1e-9;
+	const int quarkPDGs[ 3 ]{ 5 , 4 , 1 };
+
+	LCEventImpl *pLCEvent = new LCEventImpl;
+	pLCEvent->setRunNumber( run );
+	pLCEvent->setEventNumber( event );
+
+	LCCollectionVec *mcParticles = new LCCollectionVec( LCIO::MCPARTICLE );
+	LCCollectionVec *pfos = new LCCollectionVec( LCIO::RECONSTRUCTEDPARTICLE );
+	LCCollectionVec *tracks = new LCCollectionVec( LCIO::TRACK );
+	LCCollectionVec *kaonTracks = new LCCollectionVec( LCIO::TRACK );
+	kaonTracks->setSubset( true );
+	LCCollectionVec *protonTracks = new LCCollectionVec( LCIO::TRACK );
+	protonTracks->setSubset( true );
+	LCCollectionVec *recoJets = new LCCollectionVec( LCIO::RECONSTRUCTEDPARTICLE );
+	LCCollectionVec *trueJets = new LCCollectionVec( LCIO::RECONSTRUCTEDPARTICLE );
+	LCCollectionVec *finalColourNeutrals = new LCCollectionVec( LCIO::RECONSTRUCTEDPARTICLE );
+	LCCollectionVec *initialColourNeutrals = new LCCollectionVec( LCIO::RECONSTRUCTEDPARTICLE );
+	LCRelationNavigator recoMCTruthLink( LCIO::RECONSTRUCTEDPARTICLE , LCIO::MCPARTICLE );
+	LCRelationNavigator trueJetPFOLink( LCIO::RECONSTRUCTEDPARTICLE , LCIO::RECONSTRUCTEDPARTICLE );
+	LCRelationNavigator trueJetMCParticleLink( LCIO::RECONSTRUCTEDPARTICLE , LCIO::MCPARTICLE );
+	LCRelationNavigator finalElementonLink( LCIO::RECONSTRUCTEDPARTICLE , LCIO::MCPARTICLE );
+	LCRelationNavigator initialElementonLink( LCIO::RECONSTRUCTEDPARTICLE , LCIO::MCPARTICLE );
+	LCRelationNavigator finalColourNeutralLink( LCIO::RECONSTRUCTEDPARTICLE , LCIO::RECONSTRUCTEDPARTICLE );
+	LCRelationNavigator initialColourNeutralLink( LCIO::RECONSTRUCTEDPARTICLE , LCIO::RECONSTRUCTEDPARTICLE );
+
+	std::vector<ReconstructedParticleImpl*> eventRecoJets;
+	MCParticleImpl *boson = NULL;
+	ReconstructedParticleImpl *finalColourNeutral = NULL;
+	ReconstructedParticleImpl *initialColourNeutral = NULL;
+	double colourNeutralP4[ 4 ]{};
+	double jetTheta = 0.0;
+	double jetPhi = 0.0;
+	for ( int i_jet = 0 ; i_jet < m_settings.nJets ; ++i_jet )
+	{
+		// jets come in back-to-back pairs from one colour neutral
+		if ( i_jet % 2 == 0 )
+		{
+			boson = new MCParticleImpl;
+			boson->setPDG( 25 );
+			boson->setGeneratorStatus( 2 );
+			boson->setMass( 125.0 );
+			mcParticles->addElement( boson );
+			finalColourNeutral = new ReconstructedParticleImpl;
+			finalColourNeutral->addParticleID( makeParticleID( 1 , 25 ) );
+			finalColourNeutrals->addElement( finalColourNeutral );
+			initialColourNeutral = new ReconstructedParticleImpl;
+			initialColourNeutral->addParticleID( makeParticleID( 1 , 25 ) );
+			initialColourNeutrals->addElement( initialColourNeutral );
+			for ( int i = 0 ; i < 4 ; ++i ) colourNeutralP4[ i ] = 0.0;
+			jetTheta = std::acos( 1.8 * uniform( m_generator ) - 0.9 );
+			jetPhi = M_PI * ( 2.0 * uniform( m_generator ) - 1.0 );
+		}
+		else
+		{
+			jetTheta = M_PI - jetTheta;
+			jetPhi = ( jetPhi > 0.0 ? jetPhi - M_PI : jetPhi + M_PI );
+		}
+		const int quarkPDG = quarkPDGs[ ( i_jet / 2 ) % 3 ] * ( i_jet % 2 == 0 ? 1 : -1 );
+		MCParticleImpl *quark = new MCParticleImpl;
+		quark->setPDG( quarkPDG );
+		quark->setGeneratorStatus( 2 );
+		quark->addParent( boson );
+		mcParticles->addElement( quark );
+
+		// B+ / D0 of a b / c quark, parent of all MC particles of the jet
+		MCParticle *hadron = quark;
+		bool semileptonic = false;
+		if ( std::abs( quarkPDG ) == 5 || std::abs( quarkPDG ) == 4 )
+		{
+			MCParticleImpl *heavyHadron = new MCParticleImpl;
+			heavyHadron->setPDG( ( std::abs( quarkPDG ) == 5 ? 521 : 421 ) * ( quarkPDG > 0 ? 1 : -1 ) );
+			heavyHadron->setGeneratorStatus( 2 );
+			heavyHadron->addParent( quark );
+			mcParticles->addElement( heavyHadron );
+			hadron = heavyHadron;
+			semileptonic = m_settings.semileptonicFraction > 0.0 && m_settings.nNeutralMCParticlesPerJet >= 2 && uniform( m_generator ) < m_settings.semileptonicFraction;
+		}
+		const bool overlay = ( i_jet == m_settings.nJets - 1 && m_settings.overlayFraction > 0.0 && uniform( m_generator ) < m_settings.overlayFraction );
+
+		ReconstructedParticleImpl *trueJet = new ReconstructedParticleImpl;
+		trueJet->addParticleID( makeParticleID( overlay ? 4 : 1 , quarkPDG ) );
+		trueJets->addElement( trueJet );
+		ReconstructedParticleImpl *recoJet = new ReconstructedParticleImpl;
+		eventRecoJets.push_back( recoJet );
+
+		double trueJetP4[ 4 ]{};
+		double recoJetP4[ 4 ]{};
+		const int nMCParticles = m_settings.nPFOsPerJet + m_settings.nNeutralMCParticlesPerJet;
+		for ( int i_mcp = 0 ; i_mcp < nMCParticles ; ++i_mcp )
+		{
+			const bool reconstructed = ( i_mcp < m_settings.nPFOsPerJet );
+			const bool charged = reconstructed && uniform( m_generator ) < m_settings.chargedFraction;
+			int pdg = 22;
+			double mass = 0.0;
+			if ( charged )
+			{
+				const double species = uniform( m_generator );
+				pdg = ( species < m_settings.kaonFraction ? 321 : species < m_settings.kaonFraction + m_settings.protonFraction ? 2212 : 211 );
+				mass = ( pdg == 321 ? 0.493677 : pdg == 2212 ? 0.938272088 : 0.13957018 );
+				if ( uniform( m_generator ) < 0.5 ) pdg = -pdg;
+			}
+			if ( semileptonic && i_mcp == m_settings.nPFOsPerJet ) pdg = ( quarkPDG > 0 ? -11 : 11 );
+			if ( semileptonic && i_mcp == m_settings.nPFOsPerJet + 1 ) pdg = ( quarkPDG > 0 ? 12 : -12 );
+			const double energy = mass + m_settings.jetEnergy / nMCParticles * energyFraction( m_generator );
+			const double momentum = std::sqrt( energy * energy - mass * mass );
+			const double theta = std::min( std::max( jetTheta + spread( m_generator ) , 0.01 ) , M_PI - 0.01 );
+			const double phi = jetPhi + spread( m_generator );
+			const double p[ 3 ]{ momentum * std::sin( theta ) * std::cos( phi ) , momentum * std::sin( theta ) * std::sin( phi ) , momentum * std::cos( theta ) };
+
+			MCParticleImpl *mcParticle = new MCParticleImpl;
+			mcParticle->setPDG( pdg );
+			mcParticle->setGeneratorStatus( 1 );
+			mcParticle->setMass( mass );
+			mcParticle->setCharge( charged ? ( pdg > 0 ? 1.0 : -1.0 ) : std::abs( pdg ) == 11 ? ( pdg > 0 ? -1.0 : 1.0 ) : 0.0 );
+			mcParticle->setMomentum( p );
+			mcParticle->addParent( hadron );
+			mcParticles->addElement( mcParticle );
+			trueJetMCParticleLink.addRelation( trueJet , mcParticle , 1.0 );
+			for ( int i = 0 ; i < 3 ; ++i ) trueJetP4[ i ] += p[ i ];
+			trueJetP4[ 3 ] += energy;
+			if ( !reconstructed ) continue;
+
+			const double scale = 1.0 + smearing( m_generator );
+			const double pfoP4[ 4 ]{ p[ 0 ] * scale , p[ 1 ] * scale , p[ 2 ] * scale , std::sqrt( mass * mass + momentum * momentum * scale * scale ) };
+			ReconstructedParticleImpl *pfo = new ReconstructedParticleImpl;
+			pfo->setType( pdg );
+			setFourMomentum( pfo , pfoP4 );
+			pfo->setCharge( mcParticle->getCharge() );
+			if ( charged )
+			{
+				const double pT = std::sqrt( pfoP4[ 0 ] * pfoP4[ 0 ] + pfoP4[ 1 ] * pfoP4[ 1 ] );
+				TrackImpl *track = new TrackImpl;
+				track->setPhi( std::atan2( pfoP4[ 1 ] , pfoP4[ 0 ] ) );
+				track->setOmega( mcParticle->getCharge() * eB / pT );
+				track->setTanLambda( pfoP4[ 2 ] / pT );
+				tracks->addElement( track );
+				if ( std::abs( pdg ) == 321 ) kaonTracks->addElement( track );
+				if ( std::abs( pdg ) == 2212 ) protonTracks->addElement( track );
+				pfo->addTrack( track );
+			}
+			pfos->addElement( pfo );
+			recoJet->addParticle( pfo );
+			recoMCTruthLink.addRelation( pfo , mcParticle , 1.0 );
+			trueJetPFOLink.addRelation( trueJet , pfo , 1.0 );
+			for ( int i = 0 ; i < 4 ; ++i ) recoJetP4[ i ] += pfoP4[ i ];
+		}
+		setFourMomentum( trueJet , trueJetP4 );
+		setFourMomentum( recoJet , recoJetP4 );
+		const double sigmaE = 0.05 * recoJetP4[ 3 ];
+		const float covMatrix[ 10 ]{	float( sigmaE * sigmaE ) ,
+						0.0f , float( sigmaE * sigmaE ) ,
+						0.0f , 0.0f , float( sigmaE * sigmaE ) ,
+						0.0f , 0.0f , 0.0f , float( sigmaE * sigmaE ) };
+		recoJet->setCovMatrix( covMatrix );
+		quark->setMomentum( trueJetP4 );
+		quark->setMass( 0.0 );
+
+		finalElementonLink.addRelation( trueJet , quark , 1.0 );
+		initialElementonLink.addRelation( trueJet , quark , 1.0 );
+		finalColourNeutralLink.addRelation( trueJet , finalColourNeutral , 1.0 );
+		initialColourNeutralLink.addRelation( trueJet , initialColourNeutral , 1.0 );
+		finalColourNeutral->addParticle( trueJet );
+		initialColourNeutral->addParticle( trueJet );
+		for ( int i = 0 ; i < 4 ; ++i ) colourNeutralP4[ i ] += trueJetP4[ i ];
+		setFourMomentum( finalColourNeutral , colourNeutralP4 );
+		setFourMomentum( initialColourNeutral , colourNeutralP4 );
+		boson->setMomentum( colourNeutralP4 );
+	}
+
+	// jet clustering does not return the jets in the order of the true jets
+	for ( std::vector<ReconstructedParticleImpl*>::reverse_iterator recoJet = eventRecoJets.rbegin() ; recoJet != eventRecoJets.rend() ; ++recoJet ) recoJets->addElement( *recoJet );
+
+	pLCEvent->addCollection( mcParticles , "MCParticlesSkimmed" );
+	pLCEvent->addCollection( pfos , "PandoraPFOs" );
+	pLCEvent->addCollection( tracks , "MarlinTrkTracks" );
+	pLCEvent->addCollection( kaonTracks , "MarlinTrkTracksKaon" );
+	pLCEvent->addCollection( protonTracks , "MarlinTrkTracksProton" );
+	pLCEvent->addCollection( recoJets , "Durham_nJets" );
+	pLCEvent->addCollection( trueJets , "TrueJets" );
+	pLCEvent->addCollection( finalColourNeutrals , "FinalColourNeutrals" );
+	pLCEvent->addCollection( initialColourNeutrals , "InitialColourNeutrals" );
+	pLCEvent->addCollection( recoMCTruthLink.createLCCollection() , "RecoMCTruthLink" );
+	pLCEvent->addCollection( trueJetPFOLink.createLCCollection() , "TrueJetPFOLink" );
+	pLCEvent->addCollection( trueJetMCParticleLink.createLCCollection() , "TrueJetMCParticleLink" );
+	pLCEvent->addCollection( finalElementonLink.createLCCollection() , "FinalElementonLink" );
+	pLCEvent->addCollection( initialElementonLink.createLCCollection() , "InitialElementonLink" );
+	pLCEvent->addCollection( finalColourNeutralLink.createLCCollection() , "FinalColourNeutralLink" );
+	pLCEvent->addCollection( initialColourNeutralLink.createLCCollection() , "InitialColourNeutralLink" );
+	return pLCEvent;
+}
@@ -0,0 +1,55 @@
+#ifndef SyntheticEventGenerator_h
+#define SyntheticEventGenerator_h 1
+
+#include "lcio.h"
+#include <IMPL/LCEventImpl.h>
+#include <random>
+#include <string>
+
+/*
+* In-memory LCIO events with the input collections of JetErrorAnalysis, under the default collection names
+* of the processor: true hadronic jets with their MC particles, PFOs with tracks, the reconstructed jets
+* and the TrueJet collections and relations ( TrueJets, colour neutrals, TrueJet -> PFO / MCParticle /
+* elementon / colour neutral links ) in the layout written by the TrueJet processor and read by TrueJet_Parser.
+* Charged PFOs carry a track of MarlinTrkTracks; the kaon and proton tracks are also referenced from the
+* MarlinTrkTracksKaon / MarlinTrkTracksProton subset collections.
+* The MC particles of a b or c jet descend from a B+ or D0 between them and the quark, which decays
+* semileptonically in semileptonicFraction of the jets: two of the unreconstructed MC particles of the jet are
+* then an electron and its neutrino. In overlayFraction of the events the last true jet is an overlay jet
+* ( type 4 ), so that the event has one true hadronic jet less than reconstructed jets.
+*/
+class SyntheticEventGenerator
+{
+
+	public:
+
+		struct Settings
+		{
+			int				nJets = 4;
+			int				nPFOsPerJet = 25;
+			int				nNeutralMCParticlesPerJet = 10;
+			double				chargedFraction = 0.6;
+			double				kaonFraction = 0.12;
+			double				protonFraction = 0.06;
+			double				semileptonicFraction = 0.0;
+			double				overlayFraction = 0.0;
+			double				jetEnergy = 60.0;
+			double				bField = 3.5;
+			unsigned int			seed = 12345;
+		};
+
+		explicit SyntheticEventGenerator( const Settings &settings );
+
+		/*
+		* New event, owned by the caller
+		*/
+		IMPL::LCEventImpl *generate( int run , int event );
+
+	private:
+
+		Settings				m_settings;
+		std::mt19937_64				m_generator;
+
+};
+
+#endif
@@ -0,0 +1,128 @@
+/*
+* Cost of the per-particle diagnostics of the event loop with the output level at MESSAGE:
+* streamlog_out( DEBUGn ) statements filtered at run time, as before AnalysisLogging.h, against the
+* same statements written with jea_debug_out and compiled out ( ENABLE_DEBUG_LOGGING=OFF ).
+* The particles are accessed through virtual getters like the LCIO objects of the event loop.
+*
+* usage: loggingBenchmark [nParticles] [nRepetitions]
+*/
+#undef JETERRORANALYSIS_DEBUG_LOGGING
+#define JETERRORANALYSIS_DEBUG_LOGGING 0
+#include "AnalysisLogging.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+	class Particle
+	{
+		public:
+			virtual ~Particle() = default;
+			virtual int getGeneratorStatus() const = 0;
+			virtual int getPDG() const = 0;
+			virtual double getEnergy() const = 0;
+			virtual const double *getMomentum() const = 0;
+	};
+
+	class SyntheticParticle : public Particle
+	{
+		public:
+			SyntheticParticle( int pdg , double px , double py , double pz ) :
+			m_pdg( pdg ),
+			m_momentum{ px , py , pz }
+			{
+			}
+			int getGeneratorStatus() const override
+			{
+				return 1;
+			}
+			int getPDG() const override
+			{
+				return m_pdg;
+			}
+			double getEnergy() const override
+			{
+				return std::sqrt( m_momentum[ 0 ] * m_momentum[ 0 ] + m_momentum[ 1 ] * m_momentum[ 1 ] + m_momentum[ 2 ] * m_momentum[ 2 ] );
+			}
+			const double *getMomentum() const override
+			{
+				return m_momentum;
+			}
+		private:
+			int				m_pdg;
+			double				m_momentum[ 3 ];
+	};
+
+	double loopWithRuntimeFilter( const std::vector<std::unique_ptr<Particle>> &particles )
+	{
+		double energy = 0.0;
+		for ( unsigned int i_mcp = 0 ; i_mcp < particles.size() ; ++i_mcp )
+		{
+			const Particle *testMCP = particles[ i_mcp ].get();
+			streamlog_out(DEBUG1) << "	MCParticle [ " << i_mcp << " ] : 	GeneratorStatus = " << testMCP->getGeneratorStatus() << " ; 	PDGCode = " << testMCP->getPDG() << std::endl;
+			streamlog_out(DEBUG1) << "	------------------------------------------------" << std::endl;
+			streamlog_out(DEBUG1) << "	Calculating PFO 4-momentum from track parameters" << std::endl;
+			streamlog_out(DEBUG1) << "	------------------------------------------------" << std::endl;
+			streamlog_out(DEBUG2) << "	Momentum: (	" << testMCP->getMomentum()[ 0 ] << " 	, " << testMCP->getMomentum()[ 1 ] << " 	, " << testMCP->getMomentum()[ 2 ] << "	)" << std::endl;
+			if ( testMCP->getGeneratorStatus() == 1 && std::abs( testMCP->getPDG() ) == 321 ) energy += testMCP->getEnergy();
+			streamlog_out(DEBUG0) << "	Track parameters is converted to (p,E)" << std::endl;
+		}
+		return energy;
+	}
+
+	double loopCompiledOut( const std::vector<std::unique_ptr<Particle>> &particles )
+	{
+		double energy = 0.0;
+		for ( unsigned int i_mcp = 0 ; i_mcp < particles.size() ; ++i_mcp )
+		{
+			const Particle *testMCP = particles[ i_mcp ].get();
+			jea_debug_out(DEBUG1) << "	MCParticle [ " << i_mcp << " ] : 	GeneratorStatus = " << testMCP->getGeneratorStatus() << " ; 	PDGCode = " << testMCP->getPDG() << std::endl;
+			jea_debug_out(DEBUG1) << "	------------------------------------------------" << std::endl;
+			jea_debug_out(DEBUG1) << "	Calculating PFO 4-momentum from track parameters" << std::endl;
+			jea_debug_out(DEBUG1) << "	------------------------------------------------" << std::endl;
+			jea_debug_out(DEBUG2) << "	Momentum: (	" << testMCP->getMomentum()[ 0 ] << " 	, " << testMCP->getMomentum()[ 1 ] << " 	, " << testMCP->getMomentum()[ 2 ] << "	)" << std::endl;
+			if ( testMCP->getGeneratorStatus() == 1 && std::abs( testMCP->getPDG() ) == 321 ) energy += testMCP->getEnergy();
+			jea_debug_out(DEBUG0) << "	Track parameters is converted to (p,E)" << std::endl;
+		}
+		return energy;
+	}
+}
+
+int main( int argc , char **argv )
+{
+	const int nParticles = ( argc > 1 ? std::atoi( argv[ 1 ] ) : 1000 );
+	const int nRepetitions = ( argc > 2 ? std::atoi( argv[ 2 ] ) : 20000 );
+
+	streamlog::out.init( std::cout , "loggingBenchmark" );
+	streamlog::logscope scope( streamlog::out );
+	scope.setLevel<streamlog::MESSAGE>();
+
+	std::mt19937_64 generator( 12345 );
+	std::uniform_real_distribution<double> momentum( -20.0 , 20.0 );
+	const int pdgCodes[ 4 ]{ 211 , -321 , 2212 , 22 };
+	std::vector<std::unique_ptr<Particle>> particles;
+	for ( int i_mcp = 0 ; i_mcp < nParticles ; ++i_mcp ) particles.emplace_back( new SyntheticParticle( pdgCodes[ i_mcp % 4 ] , momentum( generator ) , momentum( generator ) , momentum( generator ) ) );
+
+	double runtimeFilterChecksum = 0.0;
+	double compiledOutChecksum = 0.0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for ( int i_rep = 0 ; i_rep < nRepetitions ; ++i_rep ) runtimeFilterChecksum += loopWithRuntimeFilter( particles );
+	const double runtimeFilterTime = std::chrono::duration<double,std::nano>( std::chrono::steady_clock::now() - start ).count();
+
+	start = std::chrono::steady_clock::now();
+	for ( int i_rep = 0 ; i_rep < nRepetitions ; ++i_rep ) compiledOutChecksum += loopCompiledOut( particles );
+	const double compiledOutTime = std::chrono::duration<double,std::nano>( std::chrono::steady_clock::now() - start ).count();
+
+	const double nEvaluated = static_cast<double>( nParticles ) * nRepetitions;
+	std::cout << "particles per repetition   : " << nParticles << std::endl;
+	std::cout << "streamlog_out  [ns / part.]: " << runtimeFilterTime / nEvaluated << std::endl;
+	std::cout << "jea_debug_out  [ns / part.]: " << compiledOutTime / nEvaluated << std::endl;
+	std::cout << "saved          [ns / part.]: " << ( runtimeFilterTime - compiledOutTime ) / nEvaluated << std::endl;
+	std::cout << "checksums                  : " << runtimeFilterChecksum << " , " << compiledOutChecksum << std::endl;
+	return 0;
+}
@@ -0,0 +1,332 @@
+/*
+* Runs JetErrorAnalysis outside of Marlin on synthetic in-memory events and reports the throughput
+* of processEvent together with the time spent in event generation, init() and end().
+* A pool of distinct events is generated up front and processed round-robin.
+* The per-stage table of the processor ( ProcessorStatistics ) is printed by end().
+* Global operator new is counted: the steady-state allocations per event are reported for processEvent
+* after one pass over the pool, together with the share of TrueJet_Parser::getall and
+* LCEvent::getCollectionNames, which allocate inside MarlinReco / LCIO. The remainder also includes the
+* baskets TTree::Fill writes out every few thousand events.
+* The events are then processed once more by one thread and by nThreads threads calling
+* processEventConcurrent with nConcurrentSlots = nThreads, and the speedup of the event loop is reported.
+* Finally a second pool, with semileptonic heavy-hadron decays and overlay jets, is processed with and
+* without lazyTrueJetParsing. Threaded and lazy output must equal the serial and eager output: eventTree,
+* jetTree and the histograms of the files are compared entry by entry, the exit code is 1 if they differ.
+*
+* usage: processorBenchmark [nEvents] [nJets] [nPFOsPerJet] [outputFile] [nThreads]
+*/
+#include "JetErrorAnalysis.h"
+#include "SyntheticEventGenerator.h"
+#include "marlin/StringParameters.h"
+#include "TFile.h"
+#include "TH1.h"
+#include "TKey.h"
+#include "TLeaf.h"
+#include "TTree.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	std::atomic<long long> nAllocations( 0 );
+}
+
+void *operator new( std::size_t size )
+{
+	++nAllocations;
+	if ( void *pointer = std::malloc( size > 0 ? size : 1 ) ) return pointer;
+	throw std::bad_alloc();
+}
+
+void operator delete( void *pointer ) noexcept
+{
+	std::free( pointer );
+}
+
+void operator delete( void *pointer , std::size_t ) noexcept
+{
+	std::free( pointer );
+}
+
+namespace
+{
+	typedef std::vector<std::pair<std::string,std::string>> Steering;
+	typedef std::vector<std::unique_ptr<IMPL::LCEventImpl>> EventPool;
+
+	/*
+	* Gives access to the steering of the processor, which Marlin sets through the protected setParameters
+	*/
+	class BenchmarkJetErrorAnalysis : public JetErrorAnalysis
+	{
+		public:
+
+			void configure( const std::string &outputFile , const Steering &steering = Steering() )
+			{
+				std::shared_ptr<marlin::StringParameters> parameters = std::make_shared<marlin::StringParameters>();
+				parameters->add( "outputFilename" , std::vector<std::string>{ outputFile } );
+				for ( const std::pair<std::string,std::string> &parameter : steering ) parameters->add( parameter.first , std::vector<std::string>{ parameter.second } );
+				setParameters( parameters );
+			}
+	};
+
+	/*
+	* TrueJet_Parser reading the collections of SyntheticEventGenerator, to count what getall allocates
+	*/
+	class BenchmarkTrueJetParser : public TrueJet_Parser
+	{
+		public:
+
+			BenchmarkTrueJetParser()
+			{
+				_trueJetCollectionName = "TrueJets";
+				_finalColourNeutralCollectionName = "FinalColourNeutrals";
+				_initialColourNeutralCollectionName = "InitialColourNeutrals";
+				_trueJetPFOLink = "TrueJetPFOLink";
+				_trueJetMCParticleLink = "TrueJetMCParticleLink";
+				_finalElementonLink = "FinalElementonLink";
+				_initialElementonLink = "InitialElementonLink";
+				_finalColourNeutralLink = "FinalColourNeutralLink";
+				_initialColourNeutralLink = "InitialColourNeutralLink";
+			}
+
+			std::string get_recoMCTruthLink()
+			{
+				return "RecoMCTruthLink";
+			}
+	};
+
+	double elapsedSeconds( std::chrono::steady_clock::time_point start )
+	{
+		return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+	}
+
+	EventPool generateEvents( const SyntheticEventGenerator::Settings &settings , int nEvents )
+	{
+		SyntheticEventGenerator generator( settings );
+		EventPool events;
+		for ( int i_evt = 0 ; i_evt < nEvents ; ++i_evt ) events.emplace_back( generator.generate( 1 , i_evt ) );
+		return events;
+	}
+
+	/*
+	* outputFile with "_<variant>" inserted before the extension
+	*/
+	std::string variantFile( const std::string &outputFile , const std::string &variant )
+	{
+		const std::string::size_type extension = outputFile.rfind( ".root" );
+		if ( extension == std::string::npos ) return outputFile + "_" + variant;
+		return outputFile.substr( 0 , extension ) + "_" + variant + outputFile.substr( extension );
+	}
+
+	/*
+	* One job of nEvents events, taken round-robin from the pool, from init() to end(). nThreads threads
+	* take the next event number in turn and pass it to processEventConcurrent as sequence, with their slot.
+	* Returns the wall time of the event loop.
+	*/
+	double processEvents( const EventPool &events , int nEvents , int nThreads , const std::string &outputFile , Steering steering )
+	{
+		BenchmarkJetErrorAnalysis processor;
+		steering.push_back( std::make_pair( std::string( "nConcurrentSlots" ) , std::to_string( nThreads ) ) );
+		processor.configure( outputFile , steering );
+		processor.init();
+		std::atomic<long long> nextSequence( 0 );
+		auto worker = [ & ]( int slot )
+		{
+			for ( long long sequence = nextSequence++ ; sequence < nEvents ; sequence = nextSequence++ )
+			{
+				processor.processEventConcurrent( events[ sequence % events.size() ].get() , slot , sequence );
+			}
+		};
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::vector<std::thread> threads;
+		for ( int slot = 1 ; slot < nThreads ; ++slot ) threads.emplace_back( worker , slot );
+		worker( 0 );
+		for ( std::thread &thread : threads ) thread.join();
+		const double seconds = elapsedSeconds( start );
+		processor.end();
+		return seconds;
+	}
+
+	bool sameValue( double reference , double value )
+	{
+		return value == reference || ( std::isnan( value ) && std::isnan( reference ) );
+	}
+
+	/*
+	* First difference between the leaf values of two trees, empty if every entry is the same;
+	* with flatArrays every leaf is a scalar or a count-indexed array of a basic type
+	*/
+	std::string treeDifference( TFile *referenceFile , TFile *file , const char *name )
+	{
+		TTree *reference = NULL;
+		TTree *tree = NULL;
+		referenceFile->GetObject( name , reference );
+		file->GetObject( name , tree );
+		if ( reference == NULL || tree == NULL ) return ( reference == tree ? "" : std::string( name ) + " missing" );
+		if ( reference->GetEntries() != tree->GetEntries() ) return std::string( name ) + " entries";
+		TObjArray *referenceLeaves = reference->GetListOfLeaves();
+		std::vector<std::pair<TLeaf*,TLeaf*>> leaves;
+		for ( int i_leaf = 0 ; i_leaf < referenceLeaves->GetEntriesFast() ; ++i_leaf )
+		{
+			TLeaf *referenceLeaf = static_cast<TLeaf*>( referenceLeaves->At( i_leaf ) );
+			TLeaf *leaf = tree->GetLeaf( referenceLeaf->GetName() );
+			if ( leaf == NULL ) return std::string( name ) + "." + referenceLeaf->GetName() + " missing";
+			leaves.push_back( std::make_pair( referenceLeaf , leaf ) );
+		}
+		for ( Long64_t i_entry = 0 ; i_entry < reference->GetEntries() ; ++i_entry )
+		{
+			reference->GetEntry( i_entry );
+			tree->GetEntry( i_entry );
+			for ( const std::pair<TLeaf*,TLeaf*> &leaf : leaves )
+			{
+				bool same = ( leaf.first->GetLen() == leaf.second->GetLen() );
+				for ( int i = 0 ; same && i < leaf.first->GetLen() ; ++i ) same = sameValue( leaf.first->GetValue( i ) , leaf.second->GetValue( i ) );
+				if ( same ) continue;
+				std::ostringstream difference;
+				difference << name << "." << leaf.first->GetName() << " in entry " << i_entry;
+				return difference.str();
+			}
+		}
+		return "";
+	}
+
+	/*
+	* First histogram of referenceFile missing in file or with other bin contents or errors, empty if none
+	*/
+	std::string histogramDifference( TFile *referenceFile , TFile *file )
+	{
+		TIter nextKey( referenceFile->GetListOfKeys() );
+		while ( TKey *key = static_cast<TKey*>( nextKey() ) )
+		{
+			std::unique_ptr<TObject> object( key->ReadObj() );
+			const TH1 *reference = dynamic_cast<const TH1*>( object.get() );
+			if ( reference == NULL ) continue;
+			TH1 *histogram = NULL;
+			file->GetObject( key->GetName() , histogram );
+			bool same = ( histogram != NULL && histogram->GetNbinsX() == reference->GetNbinsX() && histogram->GetEntries() == reference->GetEntries() );
+			for ( int i_bin = 0 ; same && i_bin <= reference->GetNbinsX() + 1 ; ++i_bin )
+			{
+				same = sameValue( reference->GetBinContent( i_bin ) , histogram->GetBinContent( i_bin ) ) && sameValue( reference->GetBinError( i_bin ) , histogram->GetBinError( i_bin ) );
+			}
+			if ( !same ) return key->GetName();
+		}
+		return "";
+	}
+
+	/*
+	* First difference of eventTree, jetTree or the histograms of two output files, empty if there is none
+	*/
+	std::string outputDifference( const std::string &referenceFileName , const std::string &fileName )
+	{
+		std::unique_ptr<TFile> referenceFile( TFile::Open( referenceFileName.c_str() ) );
+		std::unique_ptr<TFile> file( TFile::Open( fileName.c_str() ) );
+		if ( referenceFile == nullptr || file == nullptr ) return "output file missing";
+		std::string difference = treeDifference( referenceFile.get() , file.get() , "eventTree" );
+		if ( difference.empty() ) difference = treeDifference( referenceFile.get() , file.get() , "jetTree" );
+		if ( difference.empty() ) difference = histogramDifference( referenceFile.get() , file.get() );
+		return difference;
+	}
+}
+
+int main( int argc , char **argv )
+{
+	const int nEvents = ( argc > 1 ? std::atoi( argv[ 1 ] ) : 10000 );
+	SyntheticEventGenerator::Settings settings;
+	if ( argc > 2 ) settings.nJets = std::atoi( argv[ 2 ] );
+	if ( argc > 3 ) settings.nPFOsPerJet = std::atoi( argv[ 3 ] );
+	const std::string outputFile = ( argc > 4 ? argv[ 4 ] : "processorBenchmark.root" );
+	const int nPoolEvents = 100;
+
+	// the events in flight are at most maxPendingResults() + nThreads = 5 * nThreads apart, they must not share an LCEvent
+	const int nThreads = std::max( 1 , std::min( ( argc > 5 ? std::atoi( argv[ 5 ] ) : 4 ) , nPoolEvents / 5 ) );
+
+	streamlog::out.init( std::cout , "processorBenchmark" );
+	streamlog::logscope scope( streamlog::out );
+	scope.setLevel<streamlog::WARNING>();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	EventPool events = generateEvents( settings , nPoolEvents );
+	const double generationTime = elapsedSeconds( start );
+
+	BenchmarkJetErrorAnalysis processor;
+	processor.configure( outputFile );
+	start = std::chrono::steady_clock::now();
+	processor.init();
+	const double initTime = elapsedSeconds( start );
+
+	long long nWarmAllocations = nAllocations;
+	start = std::chrono::steady_clock::now();
+	for ( int i_evt = 0 ; i_evt < nEvents ; ++i_evt )
+	{
+		if ( i_evt == nPoolEvents ) nWarmAllocations = nAllocations;
+		processor.processEvent( events[ i_evt % nPoolEvents ].get() );
+	}
+	const double processTime = elapsedSeconds( start );
+	const int nSteadyEvents = nEvents - nPoolEvents;
+	const long long nSteadyAllocations = nAllocations - nWarmAllocations;
+
+	BenchmarkTrueJetParser trueJetParser;
+	for ( int i_evt = 0 ; i_evt < nPoolEvents ; ++i_evt ) trueJetParser.getall( events[ i_evt ].get() );
+	long long nLCIOAllocations = nAllocations;
+	for ( int i_evt = 0 ; i_evt < nPoolEvents ; ++i_evt ) events[ i_evt ]->getCollectionNames();
+	nLCIOAllocations = nAllocations - nLCIOAllocations;
+	long long nTrueJetAllocations = nAllocations;
+	for ( int i_evt = 0 ; i_evt < nPoolEvents ; ++i_evt ) trueJetParser.getall( events[ i_evt ].get() );
+	nTrueJetAllocations = nAllocations - nTrueJetAllocations;
+
+	scope.setLevel<streamlog::MESSAGE>();
+	start = std::chrono::steady_clock::now();
+	processor.end();
+	const double endTime = elapsedSeconds( start );
+
+	std::cout << "events                     : " << nEvents << " ( " << settings.nJets << " jets x " << settings.nPFOsPerJet << " PFOs )" << std::endl;
+	std::cout << "generation [ms / event]    : " << 1e3 * generationTime / nPoolEvents << std::endl;
+	std::cout << "init [ms]                  : " << 1e3 * initTime << std::endl;
+	std::cout << "processEvent [us / event]  : " << 1e6 * processTime / nEvents << std::endl;
+	std::cout << "processEvent [events / s]  : " << nEvents / processTime << std::endl;
+	std::cout << "end [ms]                   : " << 1e3 * endTime << std::endl;
+	if ( nSteadyEvents > 0 )
+	{
+		const double allocationsPerEvent = static_cast<double>( nSteadyAllocations ) / nSteadyEvents;
+		const double trueJetAllocationsPerEvent = static_cast<double>( nTrueJetAllocations ) / nPoolEvents;
+		const double lcioAllocationsPerEvent = static_cast<double>( nLCIOAllocations ) / nPoolEvents;
+		std::cout << "allocations [ / event]     : " << allocationsPerEvent << std::endl;
+		std::cout << "  TrueJet_Parser::getall   : " << trueJetAllocationsPerEvent << std::endl;
+		std::cout << "  getCollectionNames       : " << lcioAllocationsPerEvent << std::endl;
+		std::cout << "  JetErrorAnalysis         : " << allocationsPerEvent - trueJetAllocationsPerEvent - lcioAllocationsPerEvent << std::endl;
+	}
+
+	// the threaded job must write what the serial one writes
+	scope.setLevel<streamlog::WARNING>();
+	const Steering flatArrays{ { "flatArrays" , "true" } };
+	const double serialTime = processEvents( events , nEvents , 1 , variantFile( outputFile , "serial" ) , flatArrays );
+	const double threadedTime = processEvents( events , nEvents , nThreads , variantFile( outputFile , "threaded" ) , flatArrays );
+	const std::string threadedDifference = outputDifference( variantFile( outputFile , "serial" ) , variantFile( outputFile , "threaded" ) );
+	std::cout << "threads                    : " << nThreads << std::endl;
+	std::cout << "  serial [events / s]      : " << nEvents / serialTime << std::endl;
+	std::cout << "  threaded [events / s]    : " << nEvents / threadedTime << std::endl;
+	std::cout << "  speedup                  : " << serialTime / threadedTime << std::endl;
+	std::cout << "  output                   : " << ( threadedDifference.empty() ? "identical" : "differs in " + threadedDifference ) << std::endl;
+
+	// events skipped by lazyTrueJetParsing must be written as the analysed ones
+	SyntheticEventGenerator::Settings checkSettings = settings;
+	checkSettings.semileptonicFraction = 0.3;
+	checkSettings.overlayFraction = 0.2;
+	const EventPool checkEvents = generateEvents( checkSettings , nPoolEvents );
+	processEvents( checkEvents , nPoolEvents , 1 , variantFile( outputFile , "eager" ) , Steering{ { "flatArrays" , "true" } , { "lazyTrueJetParsing" , "false" } } );
+	processEvents( checkEvents , nPoolEvents , 1 , variantFile( outputFile , "lazy" ) , Steering{ { "flatArrays" , "true" } , { "lazyTrueJetParsing" , "true" } } );
+	const std::string lazyDifference = outputDifference( variantFile( outputFile , "eager" ) , variantFile( outputFile , "lazy" ) );
+	std::cout << "lazyTrueJetParsing output  : " << ( lazyDifference.empty() ? "identical" : "differs in " + lazyDifference ) << std::endl;
+	return ( threadedDifference.empty() && lazyDifference.empty() ? 0 : 1 );
+}
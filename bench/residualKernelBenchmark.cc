@@ -0,0 +1,195 @@
+/*
+* Microbenchmark of the jet residual computation: the per-jet TLorentzVector/TVector3 code that
+* getJetResiduals used before JetResidualBatch, against the batched structure-of-arrays kernel.
+* The covariance chi2 of the batch is checked against a Gaussian elimination of V x = r per jet.
+*
+* usage: residualKernelBenchmark [nJets] [nRepetitions]
+*/
+#include "JetResidualBatch.h"
+#include "TLorentzVector.h"
+#include "TVector3.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct JetPair
+	{
+		double				trueP4[ 4 ];
+		double				recoP4[ 4 ];
+		float				covMatrix[ 10 ];
+	};
+
+	/*
+	* the residual code of getJetResiduals before the batched kernel
+	*/
+	void legacyResiduals( TLorentzVector trueJetFourMomentum , const JetPair &jetPair , double *residuals )
+	{
+		double trueJetPx = trueJetFourMomentum.Px();
+		double trueJetPy = trueJetFourMomentum.Py();
+		double trueJetPz = trueJetFourMomentum.Pz();
+		double trueJetE = trueJetFourMomentum.E();
+		double trueJetTheta = trueJetFourMomentum.Theta();
+		double trueJetPhi = trueJetFourMomentum.Phi();
+		TVector3 trueP( trueJetPx , trueJetPy , trueJetPz );
+		TVector3 truePunit = trueP; truePunit.SetMag(1.0);
+		TVector3 truePt( trueJetPx , trueJetPy , 0.0 );
+		TVector3 truePtunit = truePt; truePtunit.SetMag(1.0);
+		TLorentzVector recoJetFourMomentum( jetPair.recoP4[ 0 ] , jetPair.recoP4[ 1 ] , jetPair.recoP4[ 2 ] , jetPair.recoP4[ 3 ] );
+		double recoJetPx = recoJetFourMomentum.Px();
+		double recoJetPy = recoJetFourMomentum.Py();
+		double recoJetPz = recoJetFourMomentum.Pz();
+		double recoJetPt = std::sqrt( pow( recoJetPx , 2 ) + pow( recoJetPy , 2 ) );
+		double recoJetPt2 = pow( recoJetPx , 2 ) + pow( recoJetPy , 2 );
+		double recoJetP2 = pow( recoJetPx , 2 ) + pow( recoJetPy , 2 ) + pow( recoJetPz , 2 );
+		double recoJetE = recoJetFourMomentum.E();
+		double recoJetTheta = recoJetFourMomentum.Theta();
+		double recoJetPhi = recoJetFourMomentum.Phi();
+		TVector3 recoP( recoJetPx , recoJetPy , recoJetPz );
+		TVector3 recoProtated = recoP; recoProtated.SetMag(1.0); recoProtated.SetPhi( trueJetPhi );
+		TVector3 recoPt( recoJetPx , recoJetPy , 0.0 );
+		TVector3 recoPtunit = recoPt; recoPtunit.SetMag(1.0);
+		const float *cov = jetPair.covMatrix;
+		double dTheta_dPx = recoJetPx * recoJetPz / ( recoJetP2 * recoJetPt );
+		double dTheta_dPy = recoJetPy * recoJetPz / ( recoJetP2 * recoJetPt );
+		double dTheta_dPz = -recoJetPt / recoJetP2;
+		double dPhi_dPx = -recoJetPy / recoJetPt2;
+		double dPhi_dPy = recoJetPx / recoJetPt2;
+		double sigmaTheta = std::sqrt( std::fabs( cov[ 0 ] * std::pow( dTheta_dPx , 2 ) + cov[ 2 ] * std::pow( dTheta_dPy , 2 ) + cov[ 5 ] * std::pow( dTheta_dPz , 2 ) + 2 * ( cov[ 1 ] * dTheta_dPx * dTheta_dPy ) + 2 * ( cov[ 3 ] * dTheta_dPx * dTheta_dPz ) + 2 * ( cov[ 4 ] * dTheta_dPy * dTheta_dPz ) ) );
+		double sigmaPhi = std::sqrt( std::fabs( cov[ 0 ] * std::pow( dPhi_dPx , 2 ) + cov[ 2 ] * std::pow( dPhi_dPy , 2 ) + 2 * ( cov[ 1 ] * dPhi_dPx * dPhi_dPy ) ) );
+		double ThetaResidual = ( ( recoJetTheta - trueJetTheta ) > 0 ? acos( truePunit.Dot(recoProtated) ) : -1 * acos( truePunit.Dot(recoProtated) ) );
+		double PhiResidual = ( ( recoJetPhi - trueJetPhi ) > 0 ? acos( truePtunit.Dot(recoPtunit) ) : -1 * acos( truePtunit.Dot(recoPtunit) ) );
+		residuals[ JetResidualBatch::kPx ] = recoJetPx - trueJetPx;
+		residuals[ JetResidualBatch::kPy ] = recoJetPy - trueJetPy;
+		residuals[ JetResidualBatch::kPz ] = recoJetPz - trueJetPz;
+		residuals[ JetResidualBatch::kE ] = recoJetE - trueJetE;
+		residuals[ JetResidualBatch::kTheta ] = ThetaResidual;
+		residuals[ JetResidualBatch::kPhi ] = PhiResidual;
+		residuals[ JetResidualBatch::kNormalizedPx ] = ( recoJetPx - trueJetPx ) / std::sqrt( cov[ 0 ] );
+		residuals[ JetResidualBatch::kNormalizedPy ] = ( recoJetPy - trueJetPy ) / std::sqrt( cov[ 2 ] );
+		residuals[ JetResidualBatch::kNormalizedPz ] = ( recoJetPz - trueJetPz ) / std::sqrt( cov[ 5 ] );
+		residuals[ JetResidualBatch::kNormalizedE ] = ( recoJetE - trueJetE ) / std::sqrt( cov[ 9 ] );
+		residuals[ JetResidualBatch::kNormalizedTheta ] = ThetaResidual / sigmaTheta;
+		residuals[ JetResidualBatch::kNormalizedPhi ] = PhiResidual / sigmaPhi;
+	}
+
+	/*
+	* r^T V^-1 r by Gaussian elimination with partial pivoting of the full 4x4 covariance
+	*/
+	double referenceChi2( const JetPair &jetPair )
+	{
+		static const int lowerTriangle[ 4 ][ 4 ]{ { 0 , 1 , 3 , 6 } , { 1 , 2 , 4 , 7 } , { 3 , 4 , 5 , 8 } , { 6 , 7 , 8 , 9 } };
+		double residual[ 4 ];
+		double matrix[ 4 ][ 5 ];
+		for ( int i = 0 ; i < 4 ; ++i )
+		{
+			residual[ i ] = jetPair.recoP4[ i ] - jetPair.trueP4[ i ];
+			for ( int j = 0 ; j < 4 ; ++j ) matrix[ i ][ j ] = jetPair.covMatrix[ lowerTriangle[ i ][ j ] ];
+			matrix[ i ][ 4 ] = residual[ i ];
+		}
+		for ( int i = 0 ; i < 4 ; ++i )
+		{
+			int pivot = i;
+			for ( int k = i + 1 ; k < 4 ; ++k ) if ( std::fabs( matrix[ k ][ i ] ) > std::fabs( matrix[ pivot ][ i ] ) ) pivot = k;
+			for ( int j = 0 ; j < 5 ; ++j ) std::swap( matrix[ i ][ j ] , matrix[ pivot ][ j ] );
+			for ( int k = 0 ; k < 4 ; ++k )
+			{
+				if ( k == i ) continue;
+				const double factor = matrix[ k ][ i ] / matrix[ i ][ i ];
+				for ( int j = i ; j < 5 ; ++j ) matrix[ k ][ j ] -= factor * matrix[ i ][ j ];
+			}
+		}
+		double chi2 = 0.0;
+		for ( int i = 0 ; i < 4 ; ++i ) chi2 += residual[ i ] * matrix[ i ][ 4 ] / matrix[ i ][ i ];
+		return chi2;
+	}
+
+	std::vector<JetPair> generateJetPairs( int nJets )
+	{
+		std::mt19937_64 generator( 12345 );
+		std::uniform_real_distribution<double> momentum( -80.0 , 80.0 );
+		std::normal_distribution<double> smearing( 0.0 , 2.0 );
+		std::vector<JetPair> jetPairs( nJets );
+		for ( JetPair &jetPair : jetPairs )
+		{
+			double p2 = 0.0;
+			for ( int i = 0 ; i < 3 ; ++i )
+			{
+				jetPair.trueP4[ i ] = momentum( generator );
+				jetPair.recoP4[ i ] = jetPair.trueP4[ i ] + smearing( generator );
+				p2 += jetPair.trueP4[ i ] * jetPair.trueP4[ i ];
+			}
+			jetPair.trueP4[ 3 ] = std::sqrt( p2 + 25.0 );
+			jetPair.recoP4[ 3 ] = jetPair.trueP4[ 3 ] + smearing( generator );
+			const float covMatrix[ 10 ]{ 4.0 , 0.3 , 4.0 , 0.2 , 0.1 , 4.0 , 0.5 , 0.5 , 0.5 , 5.0 };
+			for ( int i = 0 ; i < 10 ; ++i ) jetPair.covMatrix[ i ] = covMatrix[ i ];
+		}
+		return jetPairs;
+	}
+}
+
+int main( int argc , char **argv )
+{
+	const int nJets = ( argc > 1 ? std::atoi( argv[ 1 ] ) : 4096 );
+	const int nRepetitions = ( argc > 2 ? std::atoi( argv[ 2 ] ) : 200 );
+	const std::vector<JetPair> jetPairs = generateJetPairs( nJets );
+
+	std::vector<double> legacy( static_cast<std::size_t>( nJets ) * JetResidualBatch::kNResiduals );
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for ( int i_rep = 0 ; i_rep < nRepetitions ; ++i_rep )
+	{
+		for ( int i_jet = 0 ; i_jet < nJets ; ++i_jet )
+		{
+			const JetPair &jetPair = jetPairs[ i_jet ];
+			TLorentzVector trueJetFourMomentum( jetPair.trueP4[ 0 ] , jetPair.trueP4[ 1 ] , jetPair.trueP4[ 2 ] , jetPair.trueP4[ 3 ] );
+			legacyResiduals( trueJetFourMomentum , jetPair , &legacy[ static_cast<std::size_t>( i_jet ) * JetResidualBatch::kNResiduals ] );
+		}
+	}
+	const double legacyTime = std::chrono::duration<double,std::nano>( std::chrono::steady_clock::now() - start ).count();
+
+	JetResidualBatch residualBatch;
+	start = std::chrono::steady_clock::now();
+	for ( int i_rep = 0 ; i_rep < nRepetitions ; ++i_rep )
+	{
+		residualBatch.clear();
+		for ( const JetPair &jetPair : jetPairs ) residualBatch.addJet( jetPair.trueP4 , jetPair.recoP4 , jetPair.covMatrix );
+		residualBatch.compute();
+	}
+	const double batchTime = std::chrono::duration<double,std::nano>( std::chrono::steady_clock::now() - start ).count();
+
+	// the legacy code has no covariance chi2 and decorrelated residuals
+	double maxDeviation = 0.0;
+	double maxChi2Deviation = 0.0;
+	for ( int i_jet = 0 ; i_jet < nJets ; ++i_jet )
+	{
+		const double chi2 = residualBatch.residual( JetResidualBatch::kCovarianceChi2 , i_jet );
+		maxChi2Deviation = std::max( maxChi2Deviation , std::fabs( chi2 - referenceChi2( jetPairs[ i_jet ] ) ) / chi2 );
+		for ( int i_res = 0 ; i_res <= JetResidualBatch::kNormalizedPhi ; ++i_res )
+		{
+			const double deviation = std::fabs( residualBatch.residual( static_cast<JetResidualBatch::Residual>( i_res ) , i_jet ) - legacy[ static_cast<std::size_t>( i_jet ) * JetResidualBatch::kNResiduals + i_res ] );
+			if ( deviation > maxDeviation ) maxDeviation = deviation;
+		}
+	}
+
+	const double nEvaluated = static_cast<double>( nJets ) * nRepetitions;
+	std::cout << "jets per repetition   : " << nJets << std::endl;
+	std::cout << "legacy   [ns / jet]   : " << legacyTime / nEvaluated << std::endl;
+	std::cout << "batched  [ns / jet]   : " << batchTime / nEvaluated << std::endl;
+	std::cout << "speedup               : " << legacyTime / batchTime << std::endl;
+	std::cout << "max |batch - legacy|  : " << maxDeviation << std::endl;
+	std::cout << "max rel. chi2 error   : " << maxChi2Deviation << std::endl;
+
+	// a covariance with a negative eigenvalue must be flagged
+	JetPair indefinite = jetPairs.front();
+	indefinite.covMatrix[ 9 ] = 0.1;
+	residualBatch.clear();
+	residualBatch.addJet( indefinite.trueP4 , indefinite.recoP4 , indefinite.covMatrix );
+	residualBatch.compute();
+	std::cout << "indefinite flagged    : " << ( residualBatch.positiveDefinite( 0 ) ? "no" : "yes" ) << std::endl;
+	return 0;
+}
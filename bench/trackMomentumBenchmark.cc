@@ -0,0 +1,143 @@
+/*
+* Microbenchmark and accuracy check of the track four-momenta: the per-track getTrackFourMomentum code
+* against TrackMomentumBatch::compute ( polynomial sincos ) and TrackMomentumBatch::computeReference.
+* Returns 1 if the batched momenta deviate from getTrackFourMomentum by more than a few ulp.
+*
+* usage: trackMomentumBenchmark [nTracks] [nRepetitions]
+*/
+#include "TrackMomentumBatch.h"
+#include "TLorentzVector.h"
+#include "TMath.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// m_Bfield * c * mm2m * eV2GeV of JetErrorAnalysis::init for 3.5 T
+	const double eB = 3.5 * 2.99792458e8 * 1.0e-3 * 1.0e-9;
+
+	/*
+	* LCIO stores the track parameters as float
+	*/
+	struct TrackParameters
+	{
+		float				phi;
+		float				omega;
+		float				tanLambda;
+		double				mass;
+	};
+
+	/*
+	* the code of getTrackFourMomentum
+	*/
+	TLorentzVector legacyFourMomentum( const TrackParameters &track , double trackMass )
+	{
+		double Phi = track.phi;
+		double Omega = track.omega;
+		double tanLambda = track.tanLambda;
+		double pT = eB / fabs( Omega );
+		double px = pT * TMath::Cos( Phi );
+		double py = pT * TMath::Sin( Phi );
+		double pz = pT * tanLambda;
+		double E = sqrt( pow( trackMass , 2 ) + px * px + py * py + pz * pz);
+		TLorentzVector trackFourMomentum( px , py , pz , E );
+		return trackFourMomentum;
+	}
+
+	std::vector<TrackParameters> generateTracks( int nTracks )
+	{
+		const double masses[ 3 ]{ 0.13957018 , 0.493677 , 0.938272088 };
+		std::mt19937_64 generator( 12345 );
+		std::uniform_real_distribution<double> phi( -M_PI , M_PI );
+		std::uniform_real_distribution<double> logPT( std::log( 0.1 ) , std::log( 100.0 ) );
+		std::normal_distribution<double> tanLambda( 0.0 , 1.5 );
+		std::uniform_int_distribution<int> species( 0 , 2 );
+		std::vector<TrackParameters> tracks( nTracks );
+		for ( TrackParameters &track : tracks )
+		{
+			track.phi = phi( generator );
+			track.omega = ( generator() & 1 ? 1.0 : -1.0 ) * eB / std::exp( logPT( generator ) );
+			track.tanLambda = tanLambda( generator );
+			track.mass = masses[ species( generator ) ];
+		}
+		return tracks;
+	}
+
+	double ulpDeviation( double value , double reference )
+	{
+		const double ulp = std::nextafter( std::fabs( reference ) , INFINITY ) - std::fabs( reference );
+		return std::fabs( value - reference ) / ulp;
+	}
+}
+
+int main( int argc , char **argv )
+{
+	const int nTracks = ( argc > 1 ? std::atoi( argv[ 1 ] ) : 4096 );
+	const int nRepetitions = ( argc > 2 ? std::atoi( argv[ 2 ] ) : 200 );
+	const std::vector<TrackParameters> tracks = generateTracks( nTracks );
+
+	std::vector<double> legacy( static_cast<std::size_t>( nTracks ) * TrackMomentumBatch::kNComponents );
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for ( int i_rep = 0 ; i_rep < nRepetitions ; ++i_rep )
+	{
+		for ( int i_trk = 0 ; i_trk < nTracks ; ++i_trk )
+		{
+			const TLorentzVector trackFourMomentum = legacyFourMomentum( tracks[ i_trk ] , tracks[ i_trk ].mass );
+			double *fourMomentum = &legacy[ static_cast<std::size_t>( i_trk ) * TrackMomentumBatch::kNComponents ];
+			fourMomentum[ TrackMomentumBatch::kPx ] = trackFourMomentum.Px();
+			fourMomentum[ TrackMomentumBatch::kPy ] = trackFourMomentum.Py();
+			fourMomentum[ TrackMomentumBatch::kPz ] = trackFourMomentum.Pz();
+			fourMomentum[ TrackMomentumBatch::kE ] = trackFourMomentum.E();
+		}
+	}
+	const double legacyTime = std::chrono::duration<double,std::nano>( std::chrono::steady_clock::now() - start ).count();
+
+	TrackMomentumBatch referenceBatch;
+	start = std::chrono::steady_clock::now();
+	for ( int i_rep = 0 ; i_rep < nRepetitions ; ++i_rep )
+	{
+		referenceBatch.clear();
+		for ( const TrackParameters &track : tracks ) referenceBatch.addTrack( track.phi , track.omega , track.tanLambda , track.mass );
+		referenceBatch.computeReference( eB );
+	}
+	const double referenceTime = std::chrono::duration<double,std::nano>( std::chrono::steady_clock::now() - start ).count();
+
+	TrackMomentumBatch momentumBatch;
+	start = std::chrono::steady_clock::now();
+	for ( int i_rep = 0 ; i_rep < nRepetitions ; ++i_rep )
+	{
+		momentumBatch.clear();
+		for ( const TrackParameters &track : tracks ) momentumBatch.addTrack( track.phi , track.omega , track.tanLambda , track.mass );
+		momentumBatch.compute( eB );
+	}
+	const double batchTime = std::chrono::duration<double,std::nano>( std::chrono::steady_clock::now() - start ).count();
+
+	double maxReferenceDeviation = 0.0;
+	double maxBatchDeviation = 0.0;
+	for ( int i_trk = 0 ; i_trk < nTracks ; ++i_trk )
+	{
+		for ( int i_comp = 0 ; i_comp < TrackMomentumBatch::kNComponents ; ++i_comp )
+		{
+			const TrackMomentumBatch::Component component = static_cast<TrackMomentumBatch::Component>( i_comp );
+			const double reference = legacy[ static_cast<std::size_t>( i_trk ) * TrackMomentumBatch::kNComponents + i_comp ];
+			maxReferenceDeviation = std::max( maxReferenceDeviation , ulpDeviation( referenceBatch.component( component , i_trk ) , reference ) );
+			maxBatchDeviation = std::max( maxBatchDeviation , ulpDeviation( momentumBatch.component( component , i_trk ) , reference ) );
+		}
+	}
+
+	const double nEvaluated = static_cast<double>( nTracks ) * nRepetitions;
+	std::cout << "tracks per repetition      : " << nTracks << std::endl;
+	std::cout << "legacy     [ns / track]    : " << legacyTime / nEvaluated << std::endl;
+	std::cout << "reference  [ns / track]    : " << referenceTime / nEvaluated << std::endl;
+	std::cout << "batched    [ns / track]    : " << batchTime / nEvaluated << std::endl;
+	std::cout << "speedup                    : " << legacyTime / batchTime << std::endl;
+	std::cout << "max |reference - legacy|   : " << maxReferenceDeviation << " ulp" << std::endl;
+	std::cout << "max |batch - legacy|       : " << maxBatchDeviation << " ulp" << std::endl;
+
+	// px and py carry the error of sin / cos, E and pz at most one rounding more
+	return ( maxReferenceDeviation == 0.0 && maxBatchDeviation <= 4.0 ? 0 : 1 );
+}
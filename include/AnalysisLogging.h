@@ -0,0 +1,43 @@
+#ifndef AnalysisLogging_h
+#define AnalysisLogging_h 1
+
+#include "streamlog/streamlog.h"
+
+/*
+* Logging of the per-particle diagnostics ( MC particles, PFOs, tracks ) in the event loop.
+* jea_debug_out( LEVEL ) behaves like streamlog_out( LEVEL ) if the library is built with
+* JETERRORANALYSIS_DEBUG_LOGGING=1 ( CMake option ENABLE_DEBUG_LOGGING ); otherwise the statement
+* is still compiled and type checked but sits in a branch that is never taken, so neither the
+* level check nor the arguments of the stream expression cost anything at run time.
+*/
+#ifndef JETERRORANALYSIS_DEBUG_LOGGING
+#define JETERRORANALYSIS_DEBUG_LOGGING 0
+#endif
+
+#if JETERRORANALYSIS_DEBUG_LOGGING
+#define jea_debug_out( VERBOSITY ) streamlog_out( VERBOSITY )
+#else
+#define jea_debug_out( VERBOSITY ) if ( true ) {} else streamlog_out( VERBOSITY )
+#endif
+
+/*
+* Logging from the event loop, which runs on several worker threads at once with nConcurrentSlots > 1.
+* streamlog writes to one shared stream without locking, so jea_event_out( LOGGING , LEVEL ) only logs
+* if LOGGING, false for concurrent slots; jea_event_debug_out is the same for the jea_debug_out diagnostics.
+*/
+#define jea_event_out( LOGGING , VERBOSITY ) if ( !( LOGGING ) ) {} else streamlog_out( VERBOSITY )
+#if JETERRORANALYSIS_DEBUG_LOGGING
+#define jea_event_debug_out( LOGGING , VERBOSITY ) jea_event_out( LOGGING , VERBOSITY )
+#else
+#define jea_event_debug_out( LOGGING , VERBOSITY ) if ( true ) {} else streamlog_out( VERBOSITY )
+#endif
+
+/*
+* Rate limit of the per-event summaries: true for every interval-th counter value, never if interval <= 0
+*/
+inline bool logEvery( long long counter , int interval )
+{
+	return interval > 0 && counter % interval == 0;
+}
+
+#endif
@@ -0,0 +1,205 @@
+#ifndef EventContext_h
+#define EventContext_h 1
+
+#include "lcio.h"
+#include <EVENT/LCEvent.h>
+#include <EVENT/LCCollection.h>
+#include "TrackClassifier.h"
+#include "JetResidualBatch.h"
+#include "JetCovarianceBuilder.h"
+#include "JetMatcher.h"
+#include "MCParticleAncestry.h"
+#include "PointerIndex.h"
+#include "ProcessorStatistics.h"
+#include <array>
+#include <string>
+#include <vector>
+
+/*
+* Collections of one event, resolved once at the top of processEvent and passed down to the helpers,
+* together with the per-event lookup and scratch structures built from them.
+* A collection that is not in the event is recorded as missing instead of raising DataNotAvailableException.
+*/
+class EventContext
+{
+
+	public:
+
+		enum CollectionId
+		{
+			kRecoJets = 0,
+			kReferenceJets,
+			kMCParticles,
+			kRecoParticles,
+			kRecoMCTruthLink,
+			kTracks,
+			kTrueJets,
+			kFinalColourNeutrals,
+			kInitialColourNeutrals,
+			kTrueJetPFOLink,
+			kTrueJetMCParticleLink,
+			kFinalElementonLink,
+			kInitialElementonLink,
+			kFinalColourNeutralLink,
+			kInitialColourNeutralLink,
+			kNCollections
+		};
+
+		EventContext() = default;
+
+		/*
+		* Called once from init() for every configured collection
+		*/
+		void setCollectionName( CollectionId id , const std::string &collectionName );
+
+		/*
+		* false if the context belongs to one of several concurrent slots: the per-event messages are then
+		* not logged, a missing species collection is only counted
+		*/
+		void setEventLogging( bool eventLogging )
+		{
+			m_eventLogging = eventLogging;
+		}
+
+		/*
+		* Called at the top of processEvent, looks up every configured collection once
+		*/
+		void resolve( EVENT::LCEvent *pLCEvent );
+
+		/*
+		* Builds the track index of the species collections of the current event
+		*/
+		void indexTracks();
+
+		/*
+		* Builds the ancestry index of the MCParticle collection of the current event, empty if it is missing
+		*/
+		void indexMCParticles();
+
+		/*
+		* Builds the index of the TrueJets collection of the current event, the position of every true jet
+		*/
+		void indexTrueJets();
+
+		const std::string &collectionName( CollectionId id ) const
+		{
+			return m_collectionNames[ id ];
+		}
+
+		EVENT::LCEvent *event() const
+		{
+			return m_event;
+		}
+
+		EVENT::LCCollection *collection( CollectionId id ) const
+		{
+			return m_collections[ id ];
+		}
+
+		bool has( CollectionId id ) const
+		{
+			return m_collections[ id ] != NULL;
+		}
+
+		/*
+		* Jet collections and everything TrueJet_Parser::getall reads
+		*/
+		bool hasJetInput() const;
+
+		/*
+		* Comma separated names of the configured collections missing in the current event
+		*/
+		std::string missingCollections() const;
+
+		/*
+		* Mass hypothesis of the PFO tracks, configured once from init()
+		*/
+		TrackClassifier &trackClassifier()
+		{
+			return m_trackClassifier;
+		}
+
+		const TrackClassifier &trackClassifier() const
+		{
+			return m_trackClassifier;
+		}
+
+		/*
+		* Heavy-flavour history of the MCParticles of the current event, see indexMCParticles()
+		*/
+		const MCParticleAncestry &mcParticleAncestry() const
+		{
+			return m_mcParticleAncestry;
+		}
+
+		/*
+		* Position of the true jets in the TrueJets collection of the current event, see indexTrueJets()
+		*/
+		const PointerIndex<EVENT::LCObject> &trueJetIndex() const
+		{
+			return m_trueJetIndex;
+		}
+
+		/*
+		* True-reco jet matching of the current event
+		*/
+		JetMatcher &jetMatcher()
+		{
+			return m_jetMatcher;
+		}
+
+		/*
+		* Matched jets of the current event waiting for the residual computation
+		*/
+		JetResidualBatch &residualBatch()
+		{
+			return m_residualBatch;
+		}
+
+		/*
+		* Jet four-momentum and covariance rebuilt from the PFOs of the current jet
+		*/
+		JetCovarianceBuilder &jetCovarianceBuilder()
+		{
+			return m_jetCovarianceBuilder;
+		}
+
+		/*
+		* Indices of the true hadronic jets of the current event, reused between events
+		*/
+		std::vector<int> &trueHadronicJetIndices()
+		{
+			return m_trueHadronicJetIndices;
+		}
+
+		/*
+		* Stage timings and counters of the worker slot owning this context, accumulated over the job
+		*/
+		ProcessorStatistics &statistics()
+		{
+			return m_statistics;
+		}
+
+		const ProcessorStatistics &statistics() const
+		{
+			return m_statistics;
+		}
+
+	private:
+
+		std::array<std::string,kNCollections>		m_collectionNames{};
+		std::array<EVENT::LCCollection*,kNCollections>	m_collections{};
+		EVENT::LCEvent					*m_event{};
+		TrackClassifier					m_trackClassifier{};
+		JetMatcher					m_jetMatcher{};
+		MCParticleAncestry				m_mcParticleAncestry{};
+		PointerIndex<EVENT::LCObject>			m_trueJetIndex{};
+		JetResidualBatch				m_residualBatch{};
+		JetCovarianceBuilder				m_jetCovarianceBuilder{};
+		std::vector<int>				m_trueHadronicJetIndices{};
+		ProcessorStatistics				m_statistics{};
+		bool						m_eventLogging = true;
+
+};
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef EventResult_h
+#define EventResult_h 1
+
+#include "JetResidualBatch.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+/*
+* Everything JetErrorAnalysis computes for one event: the content of one eventTree entry
+* and the residuals that go into the histograms.
+* Produced by JetErrorAnalysis::analyseEvent without touching any shared state.
+*/
+struct EventResult
+{
+	typedef	std::vector<int>		IntVector;
+	typedef	std::vector<float>		floatVector;
+
+	/*
+	* Residuals of one matched jet pair at the precision they are histogrammed with, indexed by JetResidualBatch::Residual
+	*/
+	typedef std::array<double,JetResidualBatch::kNResiduals>	JetResiduals;
+
+	/*
+	* One matched pair of true hadronic and reconstructed jet, a row of jetTree
+	*/
+	struct JetRecord
+	{
+		int				trueJetIndex;
+		int				recoJetIndex;
+		int				nPFOs;
+		int				pfoListsMatch;
+		int				hasResiduals;
+		int				trueJetFlavour;
+		int				covariancePositiveDefinite;
+		double				trueE;
+		double				truePx;
+		double				truePy;
+		double				truePz;
+		double				recoE;
+		double				recoPx;
+		double				recoPy;
+		double				recoPz;
+		double				kaonTrackEnergyinJet;
+		double				protonTrackEnergyinJet;
+		JetResiduals			residuals;
+	};
+
+	/*
+	* false if the event has no jet input, such events do not get an eventTree entry
+	*/
+	bool					accepted = false;
+	int					run = 0;
+	int					event = 0;
+	int					nTrueJets = 0;
+	int					nTrueLeptons = 0;
+	int					nRecoJets = 0;
+	int					nRecoLeptons = 0;
+	int					HDecayMode = 0;
+	int					nSLDecayBHadron = 0;
+	int					nSLDecayCHadron = 0;
+	int					nSLDecayTotal = 0;
+	IntVector				trueJetType{};
+	IntVector				trueJetFlavour{};
+	floatVector				trueKaonEnergy{};
+	float					trueKaonEnergyTotal = 0.0;
+	floatVector				trueProtonEnergy{};
+	float					trueProtonEnergyTotal = 0.0;
+	floatVector				pionTrackEnergy{};
+	float					pionTrackEnergyTotal = 0.0;
+	floatVector				protonTrackEnergy{};
+	floatVector				protonTrackEnergyinJet{};
+	float					protonTrackEnergyTotal = 0.0;
+	floatVector				kaonTrackEnergy{};
+	floatVector				kaonTrackEnergyinJet{};
+	float					kaonTrackEnergyTotal = 0.0;
+	floatVector				speciesTrackEnergyTotal{};
+	std::array<floatVector,JetResidualBatch::kNResiduals>	residuals{};
+	std::vector<JetResiduals>		jetResiduals{};
+	std::vector<JetRecord>			jetRecords{};
+
+	/*
+	* Calls visitor( vector ) for every per-jet and per-track vector, always in the same order
+	*/
+	template<class Visitor> void visitVectors( Visitor &visitor )
+	{
+		visitor( trueJetType );
+		visitor( trueJetFlavour );
+		visitor( trueKaonEnergy );
+		visitor( trueProtonEnergy );
+		visitor( pionTrackEnergy );
+		visitor( protonTrackEnergy );
+		visitor( protonTrackEnergyinJet );
+		visitor( kaonTrackEnergy );
+		visitor( kaonTrackEnergyinJet );
+		visitor( speciesTrackEnergyTotal );
+		for ( floatVector &residual : residuals ) visitor( residual );
+		visitor( jetResiduals );
+		visitor( jetRecords );
+	}
+
+	/*
+	* High-water mark of the size of every vector over the events seen so far.
+	* reserve() gives a fresh or recycled EventResult the capacity of the largest event at once,
+	* so the push_back calls of the event loop do not reallocate in steady state.
+	* The list of high-water marks grows with the vectors visitVectors visits, so it has no size to keep in step.
+	*/
+	class Capacity
+	{
+		public:
+
+			void update( EventResult &result )
+			{
+				UpdateVisitor visitor{ m_highWaterMarks , 0 };
+				result.visitVectors( visitor );
+			}
+
+			void reserve( EventResult &result ) const
+			{
+				ReserveVisitor visitor{ m_highWaterMarks , 0 };
+				result.visitVectors( visitor );
+			}
+
+			/*
+			* High-water mark of the i_vector-th vector of visitVectors, 0 before the first update()
+			*/
+			std::size_t highWaterMark( std::size_t i_vector ) const
+			{
+				return ( i_vector < m_highWaterMarks.size() ? m_highWaterMarks[ i_vector ] : 0 );
+			}
+
+		private:
+
+			struct UpdateVisitor
+			{
+				std::vector<std::size_t>	&highWaterMarks;
+				std::size_t			i_vector;
+
+				template<class T> void operator()( const std::vector<T> &vector )
+				{
+					if ( i_vector == highWaterMarks.size() ) highWaterMarks.push_back( 0 );
+					highWaterMarks[ i_vector ] = std::max( highWaterMarks[ i_vector ] , vector.size() );
+					++i_vector;
+				}
+			};
+
+			struct ReserveVisitor
+			{
+				const std::vector<std::size_t>	&highWaterMarks;
+				std::size_t			i_vector;
+
+				template<class T> void operator()( std::vector<T> &vector )
+				{
+					if ( i_vector < highWaterMarks.size() && vector.capacity() < highWaterMarks[ i_vector ] ) vector.reserve( highWaterMarks[ i_vector ] );
+					++i_vector;
+				}
+			};
+
+			std::vector<std::size_t>		m_highWaterMarks{};
+	};
+
+	/*
+	* Resets the event, keeping the capacity of the vectors
+	*/
+	void clear()
+	{
+		accepted = false;
+		run = 0;
+		event = 0;
+		nTrueJets = 0;
+		nTrueLeptons = 0;
+		nRecoJets = 0;
+		nRecoLeptons = 0;
+		HDecayMode = 0;
+		nSLDecayBHadron = 0;
+		nSLDecayCHadron = 0;
+		nSLDecayTotal = 0;
+		trueJetType.clear();
+		trueJetFlavour.clear();
+		trueKaonEnergy.clear();
+		trueKaonEnergyTotal = 0.0;
+		trueProtonEnergy.clear();
+		trueProtonEnergyTotal = 0.0;
+		pionTrackEnergy.clear();
+		pionTrackEnergyTotal = 0.0;
+		protonTrackEnergy.clear();
+		protonTrackEnergyinJet.clear();
+		protonTrackEnergyTotal = 0.0;
+		kaonTrackEnergy.clear();
+		kaonTrackEnergyinJet.clear();
+		kaonTrackEnergyTotal = 0.0;
+		speciesTrackEnergyTotal.clear();
+		for ( floatVector &residual : residuals ) residual.clear();
+		jetResiduals.clear();
+		jetRecords.clear();
+	}
+};
+
+#endif
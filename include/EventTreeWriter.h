@@ -0,0 +1,99 @@
+#ifndef EventTreeWriter_h
+#define EventTreeWriter_h 1
+
+#include <deque>
+#include <string>
+#include <vector>
+#include "EventResult.h"
+#include "RtypesCore.h"
+class TBranch;
+class TFile;
+class TTree;
+
+/*
+* Books and fills eventTree and jetTree from an EventResult.
+* The compression of the output file, the basket size of the branches and the AutoFlush cluster size
+* are configurable. With flatArrays the per-jet and per-track quantities are written as count-indexed
+* leaf arrays ( e.g. ResidualPx[nJetResiduals]/F ) instead of streamed std::vector objects; the branch
+* addresses are then pointed to the vector data before every Fill, so nothing is copied.
+* jetTree has one entry of scalar branches per matched jet pair, keyed by run, event and eventEntry,
+* the entry of the event in eventTree.
+*/
+class EventTreeWriter
+{
+
+	public:
+
+		struct Settings
+		{
+			std::string			compression = "default";
+			int				compressionLevel = 4;
+			int				basketSize = 32000;
+			int				autoFlush = -30000000;
+			bool				flatArrays = false;
+			bool				jetTree = true;
+		};
+
+		EventTreeWriter() = default;
+		EventTreeWriter(const EventTreeWriter&) = delete;
+		EventTreeWriter& operator=(const EventTreeWriter&) = delete;
+
+		/*
+		* ROOT compression setting ( 100 * algorithm + level ) for "none", "ZLIB", "LZMA", "LZ4" or "ZSTD",
+		* false if the algorithm is unknown; "default" keeps the setting the file was created with
+		*/
+		static bool compressionSettings( const std::string &algorithm , int level , int &settings );
+
+		/*
+		* Creates eventTree, and jetTree if enabled, in file; the branches read from result, run and event at every fill
+		*/
+		TTree *book( TFile *file , const Settings &settings , EventResult &result , int &run , int &event );
+
+		void fill();
+
+		TTree *tree() const
+		{
+			return m_tree;
+		}
+
+		TTree *jetTree() const
+		{
+			return m_jetTree;
+		}
+
+	private:
+
+		typedef	std::vector<int>		IntVector;
+		typedef	std::vector<float>		floatVector;
+
+		/*
+		* Leaf arrays sharing one count leaf
+		*/
+		struct FlatArrayGroup
+		{
+			std::string			countName{};
+			int				count = 0;
+			std::vector<const floatVector*>	floatVectors{};
+			std::vector<TBranch*>		floatBranches{};
+			std::vector<const IntVector*>	intVectors{};
+			std::vector<TBranch*>		intBranches{};
+		};
+
+		FlatArrayGroup &bookFlatArrayGroup( const std::string &countName );
+		void bookVector( const std::string &name , floatVector &vector , FlatArrayGroup &group );
+		void bookVector( const std::string &name , IntVector &vector , FlatArrayGroup &group );
+		void bookJetTree( TFile *file , int &run , int &event );
+
+		TTree					*m_tree = NULL;
+		TTree					*m_jetTree = NULL;
+		Settings				m_settings{};
+		const EventResult			*m_result = NULL;
+		EventResult::JetRecord			m_jetRow{};
+		Long64_t				m_eventEntry = 0;
+		std::deque<FlatArrayGroup>		m_flatArrayGroups{};
+		float					m_emptyFloat = 0.0;
+		int					m_emptyInt = 0;
+
+};
+
+#endif
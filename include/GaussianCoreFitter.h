@@ -0,0 +1,65 @@
+#ifndef GaussianCoreFitter_h
+#define GaussianCoreFitter_h 1
+
+#include <vector>
+
+/*
+* Gaussian fit of the core of a binned distribution without a minimizer.
+* Every pass is a closed-form weighted least-squares fit of a parabola to the logarithm of the bin
+* contents inside the window, weighted with ( content / error )^2, i.e. the inverse variance of the
+* logarithm. The window is moved to mean +- fitRange * sigma until mean and sigma are stable, and
+* while chi2 / ndf > kMaxReducedChi2 fitRange is shrunk by 0.1 as long as it is at least kMinFitRange,
+* as the recursive ROOT fit did. The number of passes is bounded, each pass is a single loop over the bins.
+*/
+class GaussianCoreFitter
+{
+
+	public:
+
+		static constexpr int kMaxPassesPerRange = 20;
+		static constexpr double kMaxReducedChi2 = 2.0;
+		static constexpr double kMinFitRange = 0.5;
+		static constexpr double kFitRangeStep = 0.1;
+
+		struct Result
+		{
+			bool				valid = false;
+			double				constant = 0.0;
+			double				mean = 0.0;
+			double				sigma = 0.0;
+			double				meanError = 0.0;
+			double				sigmaError = 0.0;
+			double				chi2 = 0.0;
+			int				ndf = 0;
+			double				fitMin = 0.0;
+			double				fitMax = 0.0;
+			double				fitRange = 0.0;
+			int				nPasses = 0;
+		};
+
+		GaussianCoreFitter() = default;
+
+		/*
+		* Replaces the binned data; bins with non-positive content or error are ignored by the fit
+		*/
+		void setBins( const std::vector<double> &centers , const std::vector<double> &contents , const std::vector<double> &errors );
+
+		/*
+		* Starts in [ fitMin , fitMax ] with a window of +- fitRange sigma
+		*/
+		Result fit( double fitMin , double fitMax , double fitRange ) const;
+
+	private:
+
+		/*
+		* One closed-form pass in [ fitMin , fitMax ], returns false if there is no peak in the window
+		*/
+		bool fitWindow( double fitMin , double fitMax , Result &result ) const;
+
+		std::vector<double>			m_centers{};
+		std::vector<double>			m_contents{};
+		std::vector<double>			m_errors{};
+
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef JetCovarianceBuilder_h
+#define JetCovarianceBuilder_h 1
+
+#include "lcio.h"
+#include <EVENT/ReconstructedParticle.h>
+#include <EVENT/Track.h>
+#include "TrackMomentumBatch.h"
+#include <array>
+#include <cstddef>
+#include <vector>
+
+/*
+* Four-momentum and ( px , py , pz , E ) covariance of a jet rebuilt from its PFOs, with the tracks under the
+* mass hypothesis the TrackClassifier gave them. The PFOs are added in the pass that classifies their tracks:
+* a neutral PFO adds its four-momentum and covariance right away, a charged PFO stores omega and the
+* ( phi , omega , tanLambda ) block of the helix covariance of its tracks. finish() takes the track four-momenta
+* of that pass and adds J V J^T of every track, J the Jacobian of ( px , py , pz , E ) in ( phi , omega , tanLambda ).
+* The particles are taken as uncorrelated, their covariances add up.
+*/
+class JetCovarianceBuilder
+{
+
+	public:
+
+		JetCovarianceBuilder() = default;
+
+		/*
+		* Starts a new jet, keeping the capacity of the arrays
+		*/
+		void clear();
+
+		/*
+		* Adds the tracks of pfo in the order TrackClassifier::addTracks takes them, or pfo itself if it has none
+		*/
+		void addParticle( const EVENT::ReconstructedParticle *pfo );
+
+		/*
+		* Adds the tracks; momenta holds their four-momenta, computed after the same sequence of addParticle calls
+		*/
+		void finish( const TrackMomentumBatch &momenta );
+
+		/*
+		* ( px , py , pz , E ) after finish()
+		*/
+		const double *fourMomentum() const
+		{
+			return m_fourMomentum.data();
+		}
+
+		/*
+		* Lower triangle of the ( px , py , pz , E ) covariance after finish(), as ReconstructedParticle::getCovMatrix()
+		*/
+		const float *covMatrix() const
+		{
+			return m_covMatrix.data();
+		}
+
+		unsigned int nTracks() const
+		{
+			return m_omega.size();
+		}
+
+		unsigned int nNeutrals() const
+		{
+			return m_nNeutrals;
+		}
+
+	private:
+
+		enum HelixCovariance
+		{
+			kPhiPhi = 0,
+			kOmegaPhi,
+			kOmegaOmega,
+			kTanLambdaPhi,
+			kTanLambdaOmega,
+			kTanLambdaTanLambda,
+			kNHelixCovariances
+		};
+
+		std::vector<double>			m_omega{};
+		std::array<std::vector<double>,kNHelixCovariances>	m_helixCovariance{};
+		std::array<double,4>			m_fourMomentum{};
+		std::array<double,10>			m_covariance{};
+		std::array<float,10>			m_covMatrix{};
+		unsigned int				m_nNeutrals{};
+
+};
+
+#endif
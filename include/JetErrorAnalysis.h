@@ -12,10 +12,21 @@
 #include "IMPL/LCCollectionVec.h"
 #include <IMPL/ReconstructedParticleImpl.h>
 #include <IMPL/ParticleIDImpl.h>
+#include <condition_variable>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 #include "TrueJet_Parser.h"
-#include "TLorentzVector.h"
+#include "EventContext.h"
+#include "EventResult.h"
+#include "EventTreeWriter.h"
+#include "GaussianCoreFitter.h"
+#include "ProcessorStatistics.h"
+#include "ResidualHistogramSet.h"
+#include "StreamingHistogram.h"
 #include <TFile.h>
 #include <TTree.h>
 class TFile;
@@ -39,7 +50,7 @@ class JetErrorAnalysis : public Processor , public TrueJet_Parser
 		}
 
 		JetErrorAnalysis();
-		virtual ~JetErrorAnalysis() = default;
+		virtual ~JetErrorAnalysis();
 		JetErrorAnalysis(const JetErrorAnalysis&) = delete;
 		JetErrorAnalysis& operator=(const JetErrorAnalysis&) = delete;
 
@@ -61,28 +72,53 @@ class JetErrorAnalysis : public Processor , public TrueJet_Parser
 		virtual void processEvent( LCEvent * evt );
 
 		/*
-		* called for every pfo of reconstructed jet
+		* Thread-safe variant of processEvent for drivers that hand out events concurrently.
+		* slot ( < nConcurrentSlots ) identifies the calling worker, sequence is the position of the event
+		* in the input (0, 1, 2, ...) and fixes the order in which results are written.
+		* The driver passes every sequence number exactly once and a slot to one thread at a time. A result
+		* that cannot be written yet is parked; a call more than maxPendingResults() events ahead of the
+		* oldest unwritten event blocks until that one is written, which bounds the parked results.
+		* With several slots the per-event messages are not logged: streamlog is not thread safe.
 		*/
-		virtual void getTrackInformation( LCEvent* pLCEvent , EVENT::ReconstructedParticle *testPFO , double &KaonTrackEnergyinJet , double &ProtonTrackEnergyinJet );
+		void processEventConcurrent( LCEvent * evt , int slot , long long sequence );
+
+		long long maxPendingResults() const
+		{
+			return 4 * static_cast<long long>( m_nConcurrentSlots );
+		}
+
+		/*
+		* Matching, track classification and residuals of one event; only writes to result
+		*/
+		virtual void analyseEvent( EventContext &eventContext , TrueJet_Parser &trueJet , EventResult &result ) const;
 
 		/*
-		* called for every pair of true and reconstructed jets
+		* Semileptonic decay counts of the event and heaviest hadron flavour of every true jet, from the
+		* MCParticle collection and the TrueJet -> MCParticle links without TrueJet_Parser, so that events
+		* skipped by skipTrueJetParsing get the same values as analysed events
 		*/
-		virtual void getJetResiduals( TLorentzVector trueJetFourMomentum , EVENT::ReconstructedParticle *recoJet );
+		void fillFlavourHistory( EventContext &eventContext , EventResult &result ) const;
 
 		/*
-		*
+		* Reads the true jet types from the TrueJets collection without TrueJet_Parser; true if the event
+		* has no true hadronic jet or not as many as reconstructed jets, result then holds the jet counts
+		* and types and TrueJet_Parser::getall is not needed
 		*/
-		int getTrackIndex( EVENT::LCCollection *TrackCollection , EVENT::Track* inputTrk );
+		bool skipTrueJetParsing( const EventContext &eventContext , EventResult &result ) const;
 
 		/*
-		*
+		* false if the kaon or proton tracks of the whole event have less energy than minKaonTrackEnergy /
+		* minProtonTrackEnergy, so that no jet can get residuals. Uses the track batch of the classifier.
 		*/
-		TLorentzVector getTrackFourMomentum( EVENT::Track* inputTrk , double trackMass );
+		bool hasPIDTrackEnergy( EventContext &eventContext ) const;
 
 
 		virtual void InitializeHistogram( TH1F *histogram , int scale , int color , int lineWidth , int markerSize , int markerStyle );
-		virtual void doProperGaussianFit( TH1F *histogram , float fitMin , float fitMax , float fitRange );
+
+		/*
+		* Iterative Gaussian fit of the histogram core, the fitted function is stored as "gaus"
+		*/
+		virtual GaussianCoreFitter::Result doProperGaussianFit( TH1F *histogram , float fitMin , float fitMax , float fitRange );
 
 
 		virtual void check();
@@ -117,81 +153,81 @@ class JetErrorAnalysis : public Processor , public TrueJet_Parser
 		int					m_nEvt;
 		int					m_nRunSum;
 		int					m_nEvtSum;
-		int					m_nTrueJets;
-		int					m_nTrueLeptons;
-		int					m_nRecoJets;
-		int					m_nRecoLeptons;
-		int					m_HDecayMode;
-		int					m_nSLDecayBHadron;
-		int					m_nSLDecayCHadron;
-		int					m_nSLDecayTotal;
-		IntVector				m_trueJetType{};
-		IntVector				m_trueJetFlavour{};
-		floatVector				m_trueKaonEnergy{};
-		float					m_trueKaonEnergyTotal;
-		floatVector				m_trueProtonEnergy{};
-		float					m_trueProtonEnergyTotal;
-		floatVector				m_pionTrackEnergy{};
-		float					m_pionTrackEnergyTotal;
-		floatVector				m_protonTrackEnergy{};
-		floatVector				m_ProtonTrackEnergyinJet{};
-		float					m_protonTrackEnergyTotal;
-		floatVector				m_kaonTrackEnergy{};
-		floatVector				m_KaonTrackEnergyinJet{};
-		float					m_kaonTrackEnergyTotal;
-		floatVector				m_ResidualPx{};
-		floatVector				m_ResidualPy{};
-		floatVector				m_ResidualPz{};
-		floatVector				m_ResidualE{};
-		floatVector				m_ResidualTheta{};
-		floatVector				m_ResidualPhi{};
-		int					n_ResidualPx;
-		int					n_ResidualPy;
-		int					n_ResidualPz;
-		int					n_ResidualE;
-		int					n_ResidualTheta;
-		int					n_ResidualPhi;
-		floatVector				m_NormalizedResidualPx{};
-		floatVector				m_NormalizedResidualPy{};
-		floatVector				m_NormalizedResidualPz{};
-		floatVector				m_NormalizedResidualE{};
-		floatVector				m_NormalizedResidualTheta{};
-		floatVector				m_NormalizedResidualPhi{};
-		int					n_NormalizedResidualPx;
-		int					n_NormalizedResidualPy;
-		int					n_NormalizedResidualPz;
-		int					n_NormalizedResidualE;
-		int					n_NormalizedResidualTheta;
-		int					n_NormalizedResidualPhi;
-		TH1F					*h_ResidualPx{};
-		TH1F					*h_ResidualPy{};
-		TH1F					*h_ResidualPz{};
-		TH1F					*h_ResidualE{};
-		TH1F					*h_ResidualTheta{};
-		TH1F					*h_ResidualPhi{};
-		TH1F					*h_NormalizedResidualPx{};
-		TH1F					*h_NormalizedResidualPy{};
-		TH1F					*h_NormalizedResidualPz{};
-		TH1F					*h_NormalizedResidualE{};
-		TH1F					*h_NormalizedResidualTheta{};
-		TH1F					*h_NormalizedResidualPhi{};
+		EventResult				m_eventResult{};
 
 	private:
 
+		struct WorkerSlot;
+
+		/*
+		* Where the track energies of a species go in EventResult; members are NULL for species without own branches
+		*/
+		struct TrackSpeciesOutput
+		{
+			enum JetEnergy
+			{
+				kNoJetEnergy = 0,
+				kKaonJetEnergy,
+				kProtonJetEnergy,
+				kNJetEnergies
+			};
+
+			EventResult::floatVector EventResult::*	energies;
+			float EventResult::*			total;
+			JetEnergy				jetEnergy;
+		};
+
+		void configureEventContext( EventContext &eventContext );
+		void configureMagneticField();
+		void configureTrackSpecies();
+		void configureCutConfigurations();
+		bool acceptsJet( double KaonTrackEnergyinJet , double ProtonTrackEnergyinJet ) const;
+		void fillTrackEnergies( const TrackClassifier &trackClassifier , double &KaonTrackEnergyinJet , double &ProtonTrackEnergyinJet , EventResult &result ) const;
+		void commitEventResult( long long sequence , EventResult &result );
+		void fillEventResult( EventResult &result );
+		void fillHistograms( const EventResult &result );
+		TH1F *bookHistogram( const StreamingHistogram &streamingHistogram , const std::string &name , const std::string &title , const std::string &axisTitle ) const;
+
 		std::string				m_referenceJetCollection{};
 		std::string				m_recoJetCollectionName{};
 		std::string				_MCParticleColllectionName{};
 		std::string				m_MarlinTrkTracks{};
 		std::string				m_MarlinTrkTracksKAON{};
 		std::string				m_MarlinTrkTracksPROTON{};
+		StringVec				m_trackSpeciesParameter{};
+		std::vector<TrackClassifier::Species>	m_trackSpecies{};
+		std::vector<TrackSpeciesOutput>		m_trackSpeciesOutputs{};
 		std::string				_recoParticleCollectionName{};
 		std::string				_recoMCTruthLink{};
 //		std::string				_trueJetCollectionName{};
 		std::string				m_outputFile{};
+		EventTreeWriter::Settings		m_treeSettings{};
+		EventTreeWriter				m_eventTreeWriter{};
 		std::string				m_histName{};
 		int					m_histColour{};
+		int					m_eventSummaryInterval{};
+		bool					m_lazyTrueJetParsing{};
+		bool					m_skipFillOnReject{};
+		bool					m_vectorizedTrackMomenta{};
+		bool					m_rebuildJetCovariance{};
+		bool					m_writeStatisticsTree{};
+		int					m_nHistogramBins{};
+		bool					m_rootFitCrossCheck{};
+		bool					m_writePartialHistograms{};
 		float					m_minKaonTrackEnergy{};
 		float					m_minProtonTrackEnergy{};
+		StringVec				m_cutConfigurationParameter{};
+		std::vector<ResidualHistogramSet>	m_residualHistograms{};
+		int					m_nConcurrentSlots{};
+		std::vector<std::unique_ptr<WorkerSlot>>	m_workerSlots{};
+		bool					m_eventLogging{};
+		std::mutex				m_commitMutex{};
+		std::condition_variable			m_commitCondition{};
+		std::map<long long,EventResult>		m_pendingResults{};
+		std::vector<EventResult>		m_spareResults{};
+		long long				m_nextCommitSequence{};
+		long long				m_nReadEvents{};
+		ProcessorStatistics			m_commitStatistics{};
 		TFile					*m_pTFile;
 	        TTree					*m_pTTree;
 
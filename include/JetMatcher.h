@@ -0,0 +1,85 @@
+#ifndef JetMatcher_h
+#define JetMatcher_h 1
+
+#include <cstddef>
+#include <vector>
+
+/*
+* One-to-one matching of true and reconstructed jets by direction.
+* All directions are normalized once when the jets are added, the cosine matrix is built in a single
+* pass and the assignment maximizing the summed cosine is solved exactly: by enumeration for up to
+* kMaxEnumeratedJets true jets (the usual 2/4/6-jet final states) and with the Hungarian method otherwise.
+* Unlike a per-jet best-cosine search, two true jets can never claim the same reconstructed jet.
+*/
+class JetMatcher
+{
+
+	public:
+
+		static const std::size_t kMaxEnumeratedJets = 6;
+
+		JetMatcher() = default;
+
+		/*
+		* Drops all jets, keeping the allocated storage
+		*/
+		void clear();
+
+		/*
+		* momentum is ( px , py , pz ), only its direction is used
+		*/
+		void addTrueJet( const double *momentum );
+		void addRecoJet( const double *momentum );
+
+		std::size_t nTrueJets() const
+		{
+			return m_trueDirections.size() / 3;
+		}
+
+		std::size_t nRecoJets() const
+		{
+			return m_recoDirections.size() / 3;
+		}
+
+		/*
+		* Solves the assignment; element i of the returned vector is the reco jet matched to true jet i,
+		* -1 if there are more true than reco jets and true jet i is left unmatched.
+		* Up to maxEnumeratedJets reco jets the assignment is found by enumeration, 0 always takes the Hungarian method.
+		*/
+		const std::vector<int> &match( std::size_t maxEnumeratedJets = kMaxEnumeratedJets );
+
+		const std::vector<int> &matchedRecoJets() const
+		{
+			return m_matchedRecoJets;
+		}
+
+		/*
+		* Cosine of the angle between true jet i_true and reco jet i_reco, valid after match()
+		*/
+		double cosine( std::size_t i_true , std::size_t i_reco ) const
+		{
+			return m_cosines[ i_true * nRecoJets() + i_reco ];
+		}
+
+	private:
+
+		static void addDirection( const double *momentum , std::vector<double> &directions );
+		void buildCosines();
+		void matchByEnumeration();
+		void matchByHungarianMethod();
+
+		std::vector<double>			m_trueDirections{};
+		std::vector<double>			m_recoDirections{};
+		std::vector<double>			m_cosines{};
+		std::vector<int>			m_matchedRecoJets{};
+		std::vector<int>			m_permutation{};
+		std::vector<double>			m_rowPotential{};
+		std::vector<double>			m_columnPotential{};
+		std::vector<double>			m_minSlack{};
+		std::vector<int>			m_columnMatch{};
+		std::vector<int>			m_columnWay{};
+		std::vector<char>			m_columnUsed{};
+
+};
+
+#endif
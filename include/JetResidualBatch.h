@@ -0,0 +1,110 @@
+#ifndef JetResidualBatch_h
+#define JetResidualBatch_h 1
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/*
+* Matched (true, reco, covariance) jet tuples of an event, or of a block of events, in structure-of-arrays
+* layout. compute() evaluates the Px/Py/Pz/E/theta/phi residuals and the error-propagated normalized
+* residuals of all jets in tight loops over contiguous arrays, without TVector3/TLorentzVector temporaries.
+* The full ( px , py , pz , E ) covariance of every jet is Cholesky-factorized, V = L L^T, in the same way:
+* the decorrelated residuals L^-1 ( reco - true ) are independent unit Gaussians for a correct covariance,
+* their squared sum is the chi2 of the jet with 4 degrees of freedom. A covariance that is not positive
+* definite gets NaN for these and is flagged, see positiveDefinite().
+*/
+class JetResidualBatch
+{
+
+	public:
+
+		enum Residual
+		{
+			kPx = 0,
+			kPy,
+			kPz,
+			kE,
+			kTheta,
+			kPhi,
+			kNormalizedPx,
+			kNormalizedPy,
+			kNormalizedPz,
+			kNormalizedE,
+			kNormalizedTheta,
+			kNormalizedPhi,
+			kCovarianceChi2,
+			kDecorrelatedPx,
+			kDecorrelatedPy,
+			kDecorrelatedPz,
+			kDecorrelatedE,
+			kNResiduals
+		};
+
+		JetResidualBatch() = default;
+
+		/*
+		* Drops all jets, keeping the capacity of the arrays
+		*/
+		void clear();
+
+		/*
+		* trueFourMomentum and recoFourMomentum are ( px , py , pz , E ), covMatrix is the lower triangle
+		* of the ( px , py , pz , E ) covariance as stored in ReconstructedParticle::getCovMatrix()
+		*/
+		void addJet( const double *trueFourMomentum , const double *recoFourMomentum , const float *covMatrix );
+
+		/*
+		* Evaluates the residuals of all jets added since the last clear()
+		*/
+		void compute();
+
+		std::size_t size() const
+		{
+			return m_truePx.size();
+		}
+
+		double residual( Residual residualType , std::size_t i_jet ) const
+		{
+			return m_residuals[ residualType ][ i_jet ];
+		}
+
+		const std::vector<double> &residuals( Residual residualType ) const
+		{
+			return m_residuals[ residualType ];
+		}
+
+		/*
+		* The covariance of the jet has a Cholesky factorization; false as well for non-finite momenta
+		*/
+		bool positiveDefinite( std::size_t i_jet ) const
+		{
+			return !std::isnan( m_residuals[ kCovarianceChi2 ][ i_jet ] );
+		}
+
+	private:
+
+		std::vector<double>			m_truePx{};
+		std::vector<double>			m_truePy{};
+		std::vector<double>			m_truePz{};
+		std::vector<double>			m_trueE{};
+		std::vector<double>			m_recoPx{};
+		std::vector<double>			m_recoPy{};
+		std::vector<double>			m_recoPz{};
+		std::vector<double>			m_recoE{};
+		std::vector<double>			m_sigmaPx2{};
+		std::vector<double>			m_sigmaPxPy{};
+		std::vector<double>			m_sigmaPy2{};
+		std::vector<double>			m_sigmaPxPz{};
+		std::vector<double>			m_sigmaPyPz{};
+		std::vector<double>			m_sigmaPz2{};
+		std::vector<double>			m_sigmaPxE{};
+		std::vector<double>			m_sigmaPyE{};
+		std::vector<double>			m_sigmaPzE{};
+		std::vector<double>			m_sigmaE2{};
+		std::array<std::vector<double>,kNResiduals>	m_residuals{};
+
+};
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef MCParticleAncestry_h
+#define MCParticleAncestry_h 1
+
+#include "lcio.h"
+#include <EVENT/LCCollection.h>
+#include <EVENT/MCParticle.h>
+#include "PointerIndex.h"
+#include <vector>
+
+/*
+* Per-event index of the MCParticle collection with the heavy-flavour history of every particle.
+* build() visits every particle once, parents before daughters, and stores for each the heaviest hadron
+* flavour among the particle and its ancestors, the hadron carrying it and whether the particle comes from a
+* semileptonic b- or c-hadron decay. Looking these up for a particle is O(1), instead of a walk up its parent
+* chain, so the flavour of a true jet costs one lookup per particle of the jet.
+*/
+class MCParticleAncestry
+{
+
+	public:
+
+		enum Flavour
+		{
+			kLight = 0,
+			kCharm = 4,
+			kBottom = 5
+		};
+
+		MCParticleAncestry() = default;
+
+		/*
+		* Rebuild the index from mcParticleCollection, reusing the storage of the previous event.
+		* A NULL collection leaves the index empty.
+		*/
+		void build( EVENT::LCCollection *mcParticleCollection );
+
+		void clear();
+
+		/*
+		* kBottom, kCharm or kLight: the heaviest quark of a hadron, kLight for anything else
+		*/
+		static int hadronFlavour( int pdg );
+
+		/*
+		* Index of mcParticle in the indexed collection, -1 if it is not there
+		*/
+		int find( const EVENT::MCParticle *mcParticle ) const
+		{
+			return m_index.find( mcParticle );
+		}
+
+		/*
+		* Heaviest hadron flavour of mcParticle and its ancestors, kLight for a particle not in the collection
+		*/
+		int heaviestFlavour( const EVENT::MCParticle *mcParticle ) const
+		{
+			const int i_mcp = find( mcParticle );
+			return ( i_mcp != -1 ? m_nodes[ i_mcp ].flavour : kLight );
+		}
+
+		/*
+		* The nearest hadron of heaviestFlavour( mcParticle ) among mcParticle and its ancestors, NULL if that is kLight
+		*/
+		const EVENT::MCParticle *heaviestFlavourAncestor( const EVENT::MCParticle *mcParticle ) const
+		{
+			const int i_mcp = find( mcParticle );
+			return ( i_mcp != -1 && m_nodes[ i_mcp ].heaviestAncestor != -1 ? m_particles[ m_nodes[ i_mcp ].heaviestAncestor ] : NULL );
+		}
+
+		/*
+		* mcParticle is a b- or c-hadron with a charged lepton and a neutrino among its daughters
+		*/
+		bool isSemileptonicDecay( const EVENT::MCParticle *mcParticle ) const
+		{
+			const int i_mcp = find( mcParticle );
+			return i_mcp != -1 && ( m_nodes[ i_mcp ].flags & kSemileptonicDecay );
+		}
+
+		/*
+		* mcParticle is, or descends from, a semileptonically decaying hadron of flavour kBottom or kCharm
+		*/
+		bool fromSemileptonicDecay( const EVENT::MCParticle *mcParticle , int flavour ) const
+		{
+			const int i_mcp = find( mcParticle );
+			return i_mcp != -1 && ( m_nodes[ i_mcp ].flags & semileptonicFlag( flavour ) );
+		}
+
+		/*
+		* Number of semileptonically decaying hadrons of flavour kBottom or kCharm in the collection
+		*/
+		int nSemileptonicDecays( int flavour ) const
+		{
+			return ( flavour == kBottom ? m_nSemileptonicB : flavour == kCharm ? m_nSemileptonicC : 0 );
+		}
+
+		unsigned int size() const
+		{
+			return m_particles.size();
+		}
+
+	private:
+
+		enum Flag
+		{
+			kSemileptonicDecay = 1,
+			kFromSemileptonicB = 2,
+			kFromSemileptonicC = 4
+		};
+
+		struct Node
+		{
+			int				flavour;
+			int				heaviestAncestor;
+			int				flags;
+		};
+
+		static int semileptonicFlag( int flavour )
+		{
+			return ( flavour == kBottom ? kFromSemileptonicB : flavour == kCharm ? kFromSemileptonicC : 0 );
+		}
+
+		void visit( int i_mcp );
+
+		std::vector<const EVENT::MCParticle*>	m_particles{};
+		std::vector<Node>			m_nodes{};
+		std::vector<char>			m_visited{};
+		std::vector<int>			m_stack{};
+		PointerIndex<EVENT::MCParticle>		m_index{};
+		int					m_nSemileptonicB{};
+		int					m_nSemileptonicC{};
+
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef PartialHistogramTree_h
+#define PartialHistogramTree_h 1
+
+#include "StreamingHistogram.h"
+#include <string>
+#include <vector>
+class TFile;
+
+/*
+* Raw, unnormalized residual accumulators of a job as tree "partialResidualHistograms", one entry per histogram
+* with its name, title, observable, colour, maximum number of bins, number of jets and the StreamingHistogram state.
+* The partial results of any number of jobs add up histogram by histogram; the sum is what a single job over all
+* their events would have accumulated, so normalization and fits are done once after merging.
+*/
+class PartialHistogramTree
+{
+
+	public:
+
+		struct Entry
+		{
+			std::string			name;
+			std::string			title;
+			int				observable;
+			int				colour;
+			int				maxBins;
+			long long			nJets;
+			StreamingHistogram		histogram;
+		};
+
+		static const char			*treeName;
+
+		/*
+		* Writes the entries as partial tree in file
+		*/
+		static void write( TFile *file , const std::vector<Entry> &entries );
+
+		/*
+		* Appends the entries of the partial tree in file; false if there is none or it has a different binning
+		*/
+		static bool read( TFile *file , std::vector<Entry> &entries );
+
+		/*
+		* Adds every entry to the one of the same name in merged, entries of new names are appended
+		*/
+		static void merge( std::vector<Entry> &merged , const std::vector<Entry> &entries );
+
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef PointerIndex_h
+#define PointerIndex_h 1
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+* Flat open-addressing map from object pointer to int, with linear probing and a load factor of at most 1/2.
+* Meant to be rebuilt for every event: reserve() empties it and keeps the storage of the previous event.
+*/
+template <class T>
+class PointerIndex
+{
+
+	public:
+
+		PointerIndex() = default;
+
+		/*
+		* Empties the index and makes room for nKeys keys
+		*/
+		void reserve( std::size_t nKeys )
+		{
+			std::size_t capacity = 16;
+			while ( capacity < 2 * nKeys ) capacity <<= 1;
+			if ( capacity > m_slots.size() )
+			{
+				m_slots.resize( capacity );
+				m_mask = capacity - 1;
+			}
+			clear();
+		}
+
+		void clear()
+		{
+			for ( Slot &slot : m_slots ) slot = Slot{ nullptr , -1 };
+			m_size = 0;
+		}
+
+		/*
+		* Adds key, or overwrites its value if it is already there; needs a reserve() for all keys first
+		*/
+		void insert( const T *key , int value )
+		{
+			for ( std::size_t i_slot = hash( key ) & m_mask ; ; i_slot = ( i_slot + 1 ) & m_mask )
+			{
+				Slot &slot = m_slots[ i_slot ];
+				if ( slot.key == key )
+				{
+					slot.value = value;
+					return;
+				}
+				if ( slot.key == nullptr )
+				{
+					slot = Slot{ key , value };
+					++m_size;
+					return;
+				}
+			}
+		}
+
+		/*
+		* Value of key, -1 if it is not there
+		*/
+		int find( const T *key ) const
+		{
+			if ( m_size == 0 || key == nullptr ) return -1;
+			for ( std::size_t i_slot = hash( key ) & m_mask ; ; i_slot = ( i_slot + 1 ) & m_mask )
+			{
+				const Slot &slot = m_slots[ i_slot ];
+				if ( slot.key == key ) return slot.value;
+				if ( slot.key == nullptr ) return -1;
+			}
+		}
+
+		unsigned int size() const
+		{
+			return m_size;
+		}
+
+	private:
+
+		struct Slot
+		{
+			const T				*key;
+			int				value;
+		};
+
+		static std::size_t hash( const T *key )
+		{
+			// objects are at least 8-byte aligned, drop the low bits before mixing
+			std::uint64_t h = reinterpret_cast<std::uintptr_t>( key ) >> 3;
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdULL;
+			h ^= h >> 33;
+			return static_cast<std::size_t>( h );
+		}
+
+		std::vector<Slot>			m_slots{};
+		std::size_t				m_mask{};
+		unsigned int				m_size{};
+
+};
+
+#endif
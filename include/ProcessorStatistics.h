@@ -0,0 +1,144 @@
+#ifndef ProcessorStatistics_h
+#define ProcessorStatistics_h 1
+
+#include <array>
+#include <chrono>
+#include <string>
+class TFile;
+
+/*
+* Wall time per processing stage and counters of what the event loop visited or skipped.
+* Every worker slot accumulates into its own instance, merged at the end of the job, so nothing is
+* shared between threads. A stage is timed with a ScopedStageTimer on steady_clock, two clock reads
+* per scope; the stages are placed around whole loops, not single particles.
+*/
+class ProcessorStatistics
+{
+
+	public:
+
+		enum Stage
+		{
+			kProcessEvent = 0,
+			kTrueJetParsing,
+			kJetMatching,
+			kMCParticleLoop,
+			kTrackClassification,
+			kJetResiduals,
+			kTreeFill,
+			kEndOfJobFit,
+			kNStages
+		};
+
+		enum Counter
+		{
+			kEvents = 0,
+			kPFOsVisited,
+			kTracksClassified,
+			kTracksDefaultSpecies,
+			kJetsSkippedPFOMismatch,
+			kJetsNonPositiveDefiniteCovariance,
+			kEventsSkippedMissingInput,
+			kEventsSkippedDataNotAvailable,
+			kEventsRejectedJetMultiplicity,
+			kEventsRejectedPIDTracks,
+			kEventsMissingSpeciesCollection,
+			kNCounters
+		};
+
+		ProcessorStatistics() = default;
+
+		void addTime( Stage stage , std::chrono::steady_clock::duration duration )
+		{
+			m_stageTimes[ stage ] += duration;
+			++m_stageCalls[ stage ];
+		}
+
+		void count( Counter counter , long long n = 1 )
+		{
+			m_counters[ counter ] += n;
+		}
+
+		double seconds( Stage stage ) const
+		{
+			return std::chrono::duration<double>( m_stageTimes[ stage ] ).count();
+		}
+
+		long long calls( Stage stage ) const
+		{
+			return m_stageCalls[ stage ];
+		}
+
+		long long counter( Counter counter ) const
+		{
+			return m_counters[ counter ];
+		}
+
+		static const char *stageName( Stage stage );
+		static const char *counterName( Counter counter );
+
+		void merge( const ProcessorStatistics &other );
+		void clear();
+
+		/*
+		* Table of the stages ( total, per call, share of processEvent ) and the counters
+		*/
+		std::string summary() const;
+
+		/*
+		* Writes processorStatistics to file: one entry per stage and counter with name, calls and seconds
+		* ( the counters have calls = value, seconds = 0 )
+		*/
+		void writeTree( TFile *file ) const;
+
+	private:
+
+		std::array<std::chrono::steady_clock::duration,kNStages>	m_stageTimes{};
+		std::array<long long,kNStages>				m_stageCalls{};
+		std::array<long long,kNCounters>				m_counters{};
+
+};
+
+/*
+* Adds the lifetime of the scope to a stage of statistics
+*/
+class ScopedStageTimer
+{
+
+	public:
+
+		ScopedStageTimer( ProcessorStatistics &statistics , ProcessorStatistics::Stage stage ) :
+		m_statistics( statistics ),
+		m_stage( stage ),
+		m_start( std::chrono::steady_clock::now() )
+		{
+		}
+
+		~ScopedStageTimer()
+		{
+			stop();
+		}
+
+		/*
+		* Ends the measurement before the end of the scope
+		*/
+		void stop()
+		{
+			if ( m_stopped ) return;
+			m_statistics.addTime( m_stage , std::chrono::steady_clock::now() - m_start );
+			m_stopped = true;
+		}
+
+		ScopedStageTimer(const ScopedStageTimer&) = delete;
+		ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+	private:
+
+		ProcessorStatistics				&m_statistics;
+		ProcessorStatistics::Stage			m_stage;
+		std::chrono::steady_clock::time_point		m_start;
+		bool						m_stopped = false;
+
+};
+
+#endif
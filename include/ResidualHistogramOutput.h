@@ -0,0 +1,41 @@
+#ifndef ResidualHistogramOutput_h
+#define ResidualHistogramOutput_h 1
+
+#include "GaussianCoreFitter.h"
+#include "StreamingHistogram.h"
+#include <string>
+class TH1F;
+
+/*
+* Conversion of the residual accumulators into the normalized, fitted TH1F of the output file.
+* Shared by JetErrorAnalysis::end and the mergeResidualHistograms tool, so that histograms fitted
+* after merging partial results look like those of a single job.
+*/
+class ResidualHistogramOutput
+{
+
+	public:
+
+		/*
+		* TH1F in the current directory, see StreamingHistogram::makeTH1F, with the bin width in the y axis title
+		*/
+		static TH1F *book( const StreamingHistogram &streamingHistogram , const std::string &name , const std::string &title , const std::string &axisTitle , int maxBins );
+
+		/*
+		* Scales the histogram by 1 / scale and sets its line and marker style
+		*/
+		static void normalize( TH1F *histogram , double scale , int color , int lineWidth , int markerSize , int markerStyle );
+
+		/*
+		* Iterative Gaussian fit of the histogram core; a valid fit is stored with the histogram as "gaus"
+		*/
+		static GaussianCoreFitter::Result fitGaussianCore( TH1F *histogram , float fitMin , float fitMax , float fitRange );
+
+		/*
+		* y range from the maximum, title and label sizes of both axes
+		*/
+		static void formatAxes( TH1F *histogram );
+
+};
+
+#endif
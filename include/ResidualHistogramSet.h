@@ -0,0 +1,79 @@
+#ifndef ResidualHistogramSet_h
+#define ResidualHistogramSet_h 1
+
+#include "EventResult.h"
+#include "ResidualObservables.h"
+#include "StreamingHistogram.h"
+#include <array>
+#include <string>
+
+/*
+* The residual histograms of one cut configuration: a jet is filled if its kaon and proton track energies
+* reach minKaonTrackEnergy and minProtonTrackEnergy. The histograms of a configuration are named
+* h_<observable><suffix> after the residualObservables table, the default configuration has an empty suffix.
+*/
+class ResidualHistogramSet
+{
+
+	public:
+
+		ResidualHistogramSet( const std::string &title , int colour , float minKaonTrackEnergy , float minProtonTrackEnergy , const std::string &suffix );
+
+		bool accepts( double kaonTrackEnergy , double protonTrackEnergy ) const
+		{
+			return kaonTrackEnergy >= m_minKaonTrackEnergy && protonTrackEnergy >= m_minProtonTrackEnergy;
+		}
+
+		void fill( const EventResult::JetResiduals &jetResiduals );
+
+		std::string histogramName( JetResidualBatch::Residual observable ) const
+		{
+			return std::string( "h_" ) + residualObservables[ observable ].name + m_suffix;
+		}
+
+		const StreamingHistogram &histogram( JetResidualBatch::Residual observable ) const
+		{
+			return m_histograms[ observable ];
+		}
+
+		/*
+		* Number of jets filled, including those with non-finite residuals
+		*/
+		int nJets() const
+		{
+			return m_nJets;
+		}
+
+		const std::string &title() const
+		{
+			return m_title;
+		}
+
+		int colour() const
+		{
+			return m_colour;
+		}
+
+		float minKaonTrackEnergy() const
+		{
+			return m_minKaonTrackEnergy;
+		}
+
+		float minProtonTrackEnergy() const
+		{
+			return m_minProtonTrackEnergy;
+		}
+
+	private:
+
+		std::string				m_title;
+		int					m_colour;
+		float					m_minKaonTrackEnergy;
+		float					m_minProtonTrackEnergy;
+		std::string				m_suffix;
+		int					m_nJets = 0;
+		std::array<StreamingHistogram,JetResidualBatch::kNResiduals>	m_histograms{};
+
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef ResidualObservables_h
+#define ResidualObservables_h 1
+
+#include "JetResidualBatch.h"
+
+/*
+* Name and histogram axis title of a residual observable. Residuals get a fit of their Gaussian core; a chi2,
+* positive and without such a core, gets its mean per degree of freedom instead, 1 if the covariance is right.
+*/
+struct ResidualObservable
+{
+	const char				*name;
+	const char				*axisTitle;
+	bool					fitGaussianCore;
+	int					nDegreesOfFreedom;
+};
+
+/*
+* The residual observables of a matched jet pair, indexed by JetResidualBatch::Residual. The eventTree and
+* jetTree branches, the per-jet residual records and the histograms of every cut configuration are generated
+* from this table by loops of constant trip count, so a new observable is an entry here and its computation
+* in JetResidualBatch::compute(). New entries go last: the index is stored in partial histogram trees.
+*/
+constexpr ResidualObservable residualObservables[ JetResidualBatch::kNResiduals ]
+{
+	{ "ResidualPx" , "_{}p_{x,jet}^{REC} - p_{x,jet}^{MC} [GeV]" , true , 0 },
+	{ "ResidualPy" , "_{}p_{y,jet}^{REC} - p_{y,jet}^{MC} [GeV]" , true , 0 },
+	{ "ResidualPz" , "_{}p_{z,jet}^{REC} - p_{z,jet}^{MC} [GeV]" , true , 0 },
+	{ "ResidualE" , "_{}E_{jet}^{REC} - E_{jet}^{MC} [GeV]" , true , 0 },
+	{ "ResidualTheta" , "_{}#theta_{jet}^{REC} - #theta_{jet}^{MC} [rad]" , true , 0 },
+	{ "ResidualPhi" , "_{}#phi_{jet}^{REC} - #phi_{jet}^{MC} [rad]" , true , 0 },
+	{ "NormalizedResidualPx" , "(_{}p_{x,jet}^{REC} - p_{x,jet}^{MC}) / #sigma_{p_{x,jet}}" , true , 0 },
+	{ "NormalizedResidualPy" , "(_{}p_{y,jet}^{REC} - p_{y,jet}^{MC}) / #sigma_{p_{y,jet}}" , true , 0 },
+	{ "NormalizedResidualPz" , "(_{}p_{z,jet}^{REC} - p_{z,jet}^{MC}) / #sigma_{p_{z,jet}}" , true , 0 },
+	{ "NormalizedResidualE" , "(_{}E_{jet}^{REC} - E_{jet}^{MC}) / #sigma_{E_{jet}}" , true , 0 },
+	{ "NormalizedResidualTheta" , "(_{}#theta_{jet}^{REC} - #theta_{jet}^{MC}) / #sigma_{#theta_{jet}}" , true , 0 },
+	{ "NormalizedResidualPhi" , "(_{}#phi_{jet}^{REC} - #phi_{jet}^{MC}) / #sigma_{#phi_{jet}}" , true , 0 },
+	{ "CovarianceChi2" , "#chi^{2} = #Deltap^{T} V^{-1} #Deltap , #Deltap = p_{jet}^{REC} - p_{jet}^{MC}" , false , 4 },
+	{ "DecorrelatedResidualPx" , "(L^{-1} #Deltap)_{p_{x}} , V = L L^{T}" , true , 0 },
+	{ "DecorrelatedResidualPy" , "(L^{-1} #Deltap)_{p_{y}} , V = L L^{T}" , true , 0 },
+	{ "DecorrelatedResidualPz" , "(L^{-1} #Deltap)_{p_{z}} , V = L L^{T}" , true , 0 },
+	{ "DecorrelatedResidualE" , "(L^{-1} #Deltap)_{E} , V = L L^{T}" , true , 0 }
+};
+
+static_assert( residualObservables[ JetResidualBatch::kNResiduals - 1 ].name != NULL , "every JetResidualBatch::Residual needs an entry in residualObservables" );
+
+#endif
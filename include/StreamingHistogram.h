@@ -0,0 +1,101 @@
+#ifndef StreamingHistogram_h
+#define StreamingHistogram_h 1
+
+#include <array>
+#include <string>
+class TH1F;
+
+/*
+* Fixed-memory, allocation-free 1D histogram/quantile sketch that needs no range up front.
+* Values are binned log-linearly: each power of two between 2^kMinExponent and 2^kMaxExponent is split
+* into kNSubBins equal bins on either sign, so the bin width is always below 1/kNSubBins of the value.
+* Smaller magnitudes share one bin around zero, larger ones are counted as under/overflow; nothing
+* is lost silently and the moments are kept exactly. All histograms share the same binning, so
+* merging the histograms of different jobs is an element-wise sum. Conversion to TH1F, with the range
+* chosen from the data, happens only at the end of the job.
+*/
+class StreamingHistogram
+{
+
+	public:
+
+		static const int kNSubBins = 128;
+		static const int kMinExponent = -24;
+		static const int kMaxExponent = 24;
+		static const int kNOctaves = kMaxExponent - kMinExponent;
+		static const int kNSignedBins = kNOctaves * kNSubBins;
+		static const int kNStateValues = 2 * kNSignedBins + 9;
+
+		StreamingHistogram() = default;
+
+		void fill( double value );
+
+		/*
+		* Adds the content of another histogram
+		*/
+		void merge( const StreamingHistogram &other );
+
+		void reset();
+
+		/*
+		* The complete accumulator as kNStateValues doubles, e.g. to store the partial result of a job;
+		* setState restores a histogram exactly from the values written by getState
+		*/
+		void getState( double *state ) const;
+		void setState( const double *state );
+
+		/*
+		* Number of finite values filled; NaN and inf are counted separately
+		*/
+		long long entries() const
+		{
+			return m_entries;
+		}
+
+		long long invalidEntries() const
+		{
+			return m_nInvalid;
+		}
+
+		double mean() const;
+		double rms() const;
+
+		/*
+		* Value below which a fraction q of the entries lies, interpolated inside the bin
+		*/
+		double quantile( double q ) const;
+
+		/*
+		* Books a TH1F in the current directory with at most maxBins bins of a round width covering
+		* the central 99.8% of the entries; the remaining entries go to under- and overflow
+		*/
+		TH1F *makeTH1F( const std::string &name , const std::string &title , int maxBins ) const;
+
+	private:
+
+		/*
+		* Bin of a non-negative magnitude, -1 below 2^kMinExponent and kNSignedBins at or above 2^kMaxExponent
+		*/
+		static int magnitudeBin( double magnitude );
+		static double magnitudeBinLowEdge( int bin );
+
+		/*
+		* Calls visit( low , high , count ) for every non-empty bin in increasing order of value
+		*/
+		template <class Visitor> void forEachBin( Visitor visit ) const;
+
+		std::array<double,kNSignedBins>		m_negative{};
+		std::array<double,kNSignedBins>		m_positive{};
+		double					m_zero = 0.0;
+		double					m_underflow = 0.0;
+		double					m_overflow = 0.0;
+		long long				m_entries = 0;
+		long long				m_nInvalid = 0;
+		double					m_sum = 0.0;
+		double					m_sum2 = 0.0;
+		double					m_min = 0.0;
+		double					m_max = 0.0;
+
+};
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef TrackClassifier_h
+#define TrackClassifier_h 1
+
+#include "lcio.h"
+#include <EVENT/LCEvent.h>
+#include <EVENT/LCCollection.h>
+#include <EVENT/Track.h>
+#include "TrackIndex.h"
+#include "TrackMomentumBatch.h"
+#include <string>
+#include <vector>
+
+/*
+* Mass hypothesis of the PFO tracks from a table of species. Species 0 ( pion ) is the default, every other
+* species is identified by a track collection ( e.g. MarlinTrkTracksKaon ); a track takes the first species
+* in the table whose collection lists it. A single TrackIndex over all species collections gives the species
+* of a track in one lookup.
+* The tracks of a jet are collected into a TrackMomentumBatch first; the four-momenta of all of them are then
+* computed at once and the energies summed per species in one loop that indexes the species instead of
+* branching on it.
+*/
+class TrackClassifier
+{
+
+	public:
+
+		struct Species
+		{
+			int				pdg;
+			double				mass;
+			std::string			collectionName;
+		};
+
+		TrackClassifier() = default;
+
+		/*
+		* species[ 0 ] is given to the tracks found in no collection, its collectionName is not used.
+		* eB converts the track curvature to transverse momentum, pT = eB / | Omega |
+		*/
+		void setSpecies( const std::vector<Species> &species , double eB );
+
+		/*
+		* true ( default ) for TrackMomentumBatch::compute, false for the std::cos / std::sin reference
+		*/
+		void setVectorized( bool vectorized )
+		{
+			m_vectorized = vectorized;
+		}
+
+		int nSpecies() const
+		{
+			return m_species.size();
+		}
+
+		const Species &species( int i_species ) const
+		{
+			return m_species[ i_species ];
+		}
+
+		/*
+		* First species with this PDG code, -1 if there is none
+		*/
+		int findSpecies( int pdg ) const;
+
+		/*
+		* Looks up the species collections in the event; collectionNames are the names of its collections
+		*/
+		void resolve( EVENT::LCEvent *pLCEvent , const std::vector<std::string> &collectionNames );
+
+		/*
+		* Track collection of a species in the current event, NULL for species 0 or a missing collection
+		*/
+		EVENT::LCCollection *collection( int i_species ) const
+		{
+			return m_collections[ i_species ];
+		}
+
+		/*
+		* Comma separated names of the species collections missing in the current event
+		*/
+		std::string missingCollections() const;
+
+		/*
+		* Builds the track index of the current event
+		*/
+		void indexTracks();
+
+		/*
+		* Species of a track of the current event
+		*/
+		int classify( const EVENT::Track *track ) const
+		{
+			return m_trackIndex.find( track ) + 1;
+		}
+
+		/*
+		* Starts a new set of tracks, e.g. of one jet
+		*/
+		void clearTracks();
+
+		/*
+		* Classifies the tracks and stores their parameters with the mass of their species
+		*/
+		void addTracks( const EVENT::TrackVec &tracks );
+
+		/*
+		* Adds nTracks tracks of the collection of species i_species, starting at position first, all with the
+		* mass of that species, whichever species classify() gives them
+		*/
+		void addCollectionTracks( int i_species , int first , int nTracks );
+
+		/*
+		* Energy of every added track under the mass hypothesis of its species, and the sums per species
+		*/
+		void computeEnergies();
+
+		unsigned int nTracks() const
+		{
+			return m_trackSpecies.size();
+		}
+
+		const TrackMomentumBatch &momenta() const
+		{
+			return m_momenta;
+		}
+
+		int trackSpecies( unsigned int i_trk ) const
+		{
+			return m_trackSpecies[ i_trk ];
+		}
+
+		double trackEnergy( unsigned int i_trk ) const
+		{
+			return m_momenta.component( TrackMomentumBatch::kE , i_trk );
+		}
+
+		/*
+		* Sum of the energies and number of the added tracks of a species, after computeEnergies
+		*/
+		double speciesEnergy( int i_species ) const
+		{
+			return ( i_species >= 0 ? m_speciesEnergy[ i_species ] : 0.0 );
+		}
+
+		unsigned int speciesTracks( int i_species ) const
+		{
+			return ( i_species >= 0 ? m_speciesTracks[ i_species ] : 0 );
+		}
+
+	private:
+
+		std::vector<Species>			m_species{};
+		double					m_eB{};
+		bool					m_vectorized = true;
+		std::vector<EVENT::LCCollection*>	m_collections{};
+		std::vector<EVENT::LCCollection*>	m_indexedCollections{};
+		TrackIndex				m_trackIndex{};
+		std::vector<int>			m_trackSpecies{};
+		TrackMomentumBatch			m_momenta{};
+		std::vector<double>			m_speciesEnergy{};
+		std::vector<unsigned int>		m_speciesTracks{};
+
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef TrackIndex_h
+#define TrackIndex_h 1
+
+#include "lcio.h"
+#include <EVENT/LCCollection.h>
+#include <EVENT/Track.h>
+#include "PointerIndex.h"
+#include <vector>
+
+/*
+* Map from Track pointer to its index in a track collection, a PointerIndex filled from the collection.
+* Built once per collection per event, so looking up a PFO track is O(1) instead
+* of a scan over the whole collection with a dynamic_cast per element.
+*/
+class TrackIndex
+{
+
+	public:
+
+		TrackIndex() = default;
+
+		/*
+		* Rebuild the index from trackCollection, reusing the storage of the previous event.
+		* A NULL collection leaves the index empty.
+		*/
+		void build( EVENT::LCCollection *trackCollection );
+
+		/*
+		* Rebuild the index from several collections: the value of a track is the position of the first
+		* collection in trackCollections that lists it. NULL collections are skipped.
+		*/
+		void build( const std::vector<EVENT::LCCollection*> &trackCollections );
+
+		/*
+		* Index of inputTrk in the indexed collection ( position of its collection ), -1 if it is not there
+		*/
+		int find( const EVENT::Track *inputTrk ) const
+		{
+			return m_index.find( inputTrk );
+		}
+
+		bool contains( const EVENT::Track *inputTrk ) const
+		{
+			return find( inputTrk ) != -1;
+		}
+
+		unsigned int size() const
+		{
+			return m_index.size();
+		}
+
+		void clear()
+		{
+			m_index.clear();
+		}
+
+	private:
+
+		PointerIndex<EVENT::Track>		m_index{};
+
+};
+
+#endif
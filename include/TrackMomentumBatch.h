@@ -0,0 +1,86 @@
+#ifndef TrackMomentumBatch_h
+#define TrackMomentumBatch_h 1
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+/*
+* Track parameters ( phi , omega , tanLambda ) and mass hypotheses of a set of tracks in structure-of-arrays
+* layout. compute() converts all of them to ( px , py , pz , E ) in loops over contiguous arrays, with a
+* polynomial sincos that the compiler can vectorize; computeReference() does the same with std::cos / std::sin
+* and gives the values of the former per-track JetErrorAnalysis::getTrackFourMomentum.
+*/
+class TrackMomentumBatch
+{
+
+	public:
+
+		enum Component
+		{
+			kPx = 0,
+			kPy,
+			kPz,
+			kE,
+			kNComponents
+		};
+
+		TrackMomentumBatch() = default;
+
+		/*
+		* Drops all tracks, keeping the capacity of the arrays
+		*/
+		void clear();
+
+		void addTrack( double phi , double omega , double tanLambda , double mass )
+		{
+			m_phi.push_back( phi );
+			m_omega.push_back( omega );
+			m_tanLambda.push_back( tanLambda );
+			m_mass.push_back( mass );
+		}
+
+		/*
+		* Four-momenta of all tracks added since the last clear(); eB converts the curvature to
+		* transverse momentum, pT = eB / | omega |
+		*/
+		void compute( double eB );
+
+		/*
+		* As compute(), one track at a time with the functions of the standard library
+		*/
+		void computeReference( double eB );
+
+		std::size_t size() const
+		{
+			return m_phi.size();
+		}
+
+		double component( Component component , std::size_t i_trk ) const
+		{
+			return m_fourMomenta[ component ][ i_trk ];
+		}
+
+		const std::vector<double> &components( Component component ) const
+		{
+			return m_fourMomenta[ component ];
+		}
+
+		/*
+		* sin and cos of n angles; accurate to a few ulp for | x | < 1e8 ( track phi is within [ -pi , pi ] )
+		*/
+		static void sinCos( std::size_t n , const double *x , double *sinX , double *cosX );
+
+	private:
+
+		std::vector<double>			m_phi{};
+		std::vector<double>			m_omega{};
+		std::vector<double>			m_tanLambda{};
+		std::vector<double>			m_mass{};
+		std::vector<double>			m_sinPhi{};
+		std::vector<double>			m_cosPhi{};
+		std::array<std::vector<double>,kNComponents>	m_fourMomenta{};
+
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include "EventContext.h"
+#include <algorithm>
+
+// ----- include for verbosity dependend logging ---------
+#include "marlin/VerbosityLevels.h"
+#include "AnalysisLogging.h"
+
+void EventContext::setCollectionName( CollectionId id , const std::string &collectionName )
+{
+	m_collectionNames[ id ] = collectionName;
+}
+
+void EventContext::resolve( EVENT::LCEvent *pLCEvent )
+{
+	m_event = pLCEvent;
+	m_collections.fill( NULL );
+	const std::vector<std::string> *collectionNames = pLCEvent->getCollectionNames();
+	for ( int i_col = 0 ; i_col < kNCollections ; ++i_col )
+	{
+		const std::string &collectionName = m_collectionNames[ i_col ];
+		if ( collectionName.empty() ) continue;
+		if ( std::find( collectionNames->begin() , collectionNames->end() , collectionName ) == collectionNames->end() ) continue;
+		m_collections[ i_col ] = pLCEvent->getCollection( collectionName );
+	}
+	m_trackClassifier.resolve( pLCEvent , *collectionNames );
+}
+
+void EventContext::indexTracks()
+{
+	const std::string missing = m_trackClassifier.missingCollections();
+	if ( !missing.empty() )
+	{
+		m_statistics.count( ProcessorStatistics::kEventsMissingSpeciesCollection );
+		jea_event_out( m_eventLogging , WARNING ) << "	Could not find  " << missing << " Collection" << std::endl;
+	}
+	m_trackClassifier.indexTracks();
+}
+
+void EventContext::indexMCParticles()
+{
+	if ( !has( kMCParticles ) )
+	{
+		jea_event_out( m_eventLogging , DEBUG3 ) << "	Could not find  " << m_collectionNames[ kMCParticles ] << " Collection, true jets get no flavour" << std::endl;
+	}
+	m_mcParticleAncestry.build( m_collections[ kMCParticles ] );
+}
+
+void EventContext::indexTrueJets()
+{
+	EVENT::LCCollection *trueJetCol = m_collections[ kTrueJets ];
+	const int njets = ( trueJetCol != NULL ? trueJetCol->getNumberOfElements() : 0 );
+	m_trueJetIndex.reserve( njets );
+
+	// inserted from the last jet to the first, so a jet listed twice keeps its first position
+	for ( int i_jet = njets - 1 ; i_jet >= 0 ; --i_jet ) m_trueJetIndex.insert( trueJetCol->getElementAt( i_jet ) , i_jet );
+}
+
+bool EventContext::hasJetInput() const
+{
+	return	has( kRecoJets ) && has( kReferenceJets ) &&
+		has( kTrueJets ) && has( kFinalColourNeutrals ) && has( kInitialColourNeutrals ) &&
+		has( kTrueJetPFOLink ) && has( kTrueJetMCParticleLink ) &&
+		has( kFinalElementonLink ) && has( kInitialElementonLink ) &&
+		has( kFinalColourNeutralLink ) && has( kInitialColourNeutralLink );
+}
+
+std::string EventContext::missingCollections() const
+{
+	std::string missing{};
+	for ( int i_col = 0 ; i_col < kNCollections ; ++i_col )
+	{
+		if ( m_collectionNames[ i_col ].empty() || m_collections[ i_col ] != NULL ) continue;
+		if ( !missing.empty() ) missing += ", ";
+		missing += m_collectionNames[ i_col ];
+	}
+	return missing;
+}
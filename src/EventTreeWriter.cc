@@ -0,0 +1,164 @@
+#include "EventTreeWriter.h"
+#include "ResidualObservables.h"
+#include <algorithm>
+#include "TBranch.h"
+#include "TFile.h"
+#include "TTree.h"
+
+bool EventTreeWriter::compressionSettings( const std::string &algorithm , int level , int &settings )
+{
+	// ROOT::RCompressionSetting::EAlgorithm
+	static const char *algorithms[ 6 ]{ "none" , "ZLIB" , "LZMA" , "" , "LZ4" , "ZSTD" };
+	level = std::min( std::max( level , 1 ) , 9 );
+	for ( int i_algorithm = 0 ; i_algorithm < 6 ; ++i_algorithm )
+	{
+		if ( algorithm.empty() || algorithm != algorithms[ i_algorithm ] ) continue;
+		settings = ( i_algorithm == 0 ? 0 : 100 * i_algorithm + level );
+		return true;
+	}
+	return false;
+}
+
+EventTreeWriter::FlatArrayGroup &EventTreeWriter::bookFlatArrayGroup( const std::string &countName )
+{
+	m_flatArrayGroups.push_back( FlatArrayGroup() );
+	FlatArrayGroup &group = m_flatArrayGroups.back();
+	group.countName = countName;
+	if ( m_settings.flatArrays ) m_tree->Branch( countName.c_str() , &group.count , ( countName + "/I" ).c_str() , m_settings.basketSize );
+	return group;
+}
+
+void EventTreeWriter::bookVector( const std::string &name , floatVector &vector , FlatArrayGroup &group )
+{
+	if ( !m_settings.flatArrays )
+	{
+		m_tree->Branch( name.c_str() , &vector , m_settings.basketSize );
+		return;
+	}
+	group.floatVectors.push_back( &vector );
+	group.floatBranches.push_back( m_tree->Branch( name.c_str() , &m_emptyFloat , ( name + "[" + group.countName + "]/F" ).c_str() , m_settings.basketSize ) );
+}
+
+void EventTreeWriter::bookVector( const std::string &name , IntVector &vector , FlatArrayGroup &group )
+{
+	if ( !m_settings.flatArrays )
+	{
+		m_tree->Branch( name.c_str() , &vector , m_settings.basketSize );
+		return;
+	}
+	group.intVectors.push_back( &vector );
+	group.intBranches.push_back( m_tree->Branch( name.c_str() , &m_emptyInt , ( name + "[" + group.countName + "]/I" ).c_str() , m_settings.basketSize ) );
+}
+
+TTree *EventTreeWriter::book( TFile *file , const Settings &settings , EventResult &result , int &run , int &event )
+{
+	m_settings = settings;
+	m_flatArrayGroups.clear();
+	int compression = 0;
+	if ( compressionSettings( m_settings.compression , m_settings.compressionLevel , compression ) ) file->SetCompressionSettings( compression );
+
+	m_tree = new TTree("eventTree","eventTree");
+	m_tree->SetDirectory(file);
+	m_tree->SetAutoFlush( m_settings.autoFlush );
+	const int basketSize = m_settings.basketSize;
+	m_tree->Branch("run", &run, "run/I", basketSize);
+	m_tree->Branch("event", &event, "event/I", basketSize);
+	m_tree->Branch("nTrueJets",&result.nTrueJets,"nTrueJets/I", basketSize) ;
+	m_tree->Branch("nTrueLeptons",&result.nTrueLeptons,"nTrueLeptons/I", basketSize) ;
+	m_tree->Branch("nRecoJets",&result.nRecoJets,"nRecoJets/I", basketSize) ;
+	m_tree->Branch("nRecoLeptons",&result.nRecoLeptons,"nRecoLeptons/I", basketSize) ;
+	m_tree->Branch("HDecayMode",&result.HDecayMode,"HDecayMode/I", basketSize) ;
+	m_tree->Branch("nSLDecayBHadron",&result.nSLDecayBHadron,"nSLDecayBHadron/I", basketSize) ;
+	m_tree->Branch("nSLDecayCHadron",&result.nSLDecayCHadron,"nSLDecayCHadron/I", basketSize) ;
+	m_tree->Branch("nSLDecayTotal",&result.nSLDecayTotal,"nSLDecayTotal/I", basketSize) ;
+	bookVector( "trueKaonEnergy" , result.trueKaonEnergy , bookFlatArrayGroup( "nTrueKaons" ) );
+	m_tree->Branch("trueKaonEnergyTotal",&result.trueKaonEnergyTotal,"trueKaonEnergyTotal/F", basketSize) ;
+	bookVector( "trueProtonEnergy" , result.trueProtonEnergy , bookFlatArrayGroup( "nTrueProtons" ) );
+	m_tree->Branch("trueProtonEnergyTotal",&result.trueProtonEnergyTotal,"trueProtonEnergyTotal/F", basketSize) ;
+	bookVector( "pionTrackEnergy" , result.pionTrackEnergy , bookFlatArrayGroup( "nPionTracks" ) );
+	m_tree->Branch("pionTrackEnergyTotal",&result.pionTrackEnergyTotal,"pionTrackEnergyTotal/F", basketSize) ;
+	bookVector( "protonTrackEnergy" , result.protonTrackEnergy , bookFlatArrayGroup( "nProtonTracks" ) );
+	FlatArrayGroup &hadronicJets = bookFlatArrayGroup( "nHadronicJets" );
+	bookVector( "protonTrackEnergyinJet" , result.protonTrackEnergyinJet , hadronicJets );
+	m_tree->Branch("protonTrackEnergyTotal",&result.protonTrackEnergyTotal,"protonTrackEnergyTotal/F", basketSize) ;
+	bookVector( "kaonTrackEnergy" , result.kaonTrackEnergy , bookFlatArrayGroup( "nKaonTracks" ) );
+	bookVector( "kaonTrackEnergyinJet" , result.kaonTrackEnergyinJet , hadronicJets );
+	m_tree->Branch("kaonTrackEnergyTotal",&result.kaonTrackEnergyTotal,"kaonTrackEnergyTotal/F", basketSize) ;
+	bookVector( "speciesTrackEnergyTotal" , result.speciesTrackEnergyTotal , bookFlatArrayGroup( "nTrackSpecies" ) );
+	FlatArrayGroup &jetResiduals = bookFlatArrayGroup( "nJetResiduals" );
+	for ( int i_obs = 0 ; i_obs < JetResidualBatch::kNResiduals ; ++i_obs )
+	{
+		bookVector( residualObservables[ i_obs ].name , result.residuals[ i_obs ] , jetResiduals );
+	}
+	bookVector( "trueJetType" , result.trueJetType , bookFlatArrayGroup( "nTrueJetTypes" ) );
+	bookVector( "trueJetFlavour" , result.trueJetFlavour , bookFlatArrayGroup( "nTrueJetFlavours" ) );
+	m_result = &result;
+	m_jetTree = NULL;
+	if ( m_settings.jetTree ) bookJetTree( file , run , event );
+	return m_tree;
+}
+
+void EventTreeWriter::bookJetTree( TFile *file , int &run , int &event )
+{
+	m_jetTree = new TTree("jetTree","jetTree");
+	m_jetTree->SetDirectory(file);
+	m_jetTree->SetAutoFlush( m_settings.autoFlush );
+	const int basketSize = m_settings.basketSize;
+	EventResult::JetRecord &row = m_jetRow;
+	m_jetTree->Branch("run", &run, "run/I", basketSize);
+	m_jetTree->Branch("event", &event, "event/I", basketSize);
+	m_jetTree->Branch("eventEntry", &m_eventEntry, "eventEntry/L", basketSize);
+	m_jetTree->Branch("trueJetIndex", &row.trueJetIndex, "trueJetIndex/I", basketSize);
+	m_jetTree->Branch("recoJetIndex", &row.recoJetIndex, "recoJetIndex/I", basketSize);
+	m_jetTree->Branch("nPFOs", &row.nPFOs, "nPFOs/I", basketSize);
+	m_jetTree->Branch("pfoListsMatch", &row.pfoListsMatch, "pfoListsMatch/I", basketSize);
+	m_jetTree->Branch("hasResiduals", &row.hasResiduals, "hasResiduals/I", basketSize);
+	m_jetTree->Branch("trueJetFlavour", &row.trueJetFlavour, "trueJetFlavour/I", basketSize);
+	m_jetTree->Branch("covariancePositiveDefinite", &row.covariancePositiveDefinite, "covariancePositiveDefinite/I", basketSize);
+	m_jetTree->Branch("trueE", &row.trueE, "trueE/D", basketSize);
+	m_jetTree->Branch("truePx", &row.truePx, "truePx/D", basketSize);
+	m_jetTree->Branch("truePy", &row.truePy, "truePy/D", basketSize);
+	m_jetTree->Branch("truePz", &row.truePz, "truePz/D", basketSize);
+	m_jetTree->Branch("recoE", &row.recoE, "recoE/D", basketSize);
+	m_jetTree->Branch("recoPx", &row.recoPx, "recoPx/D", basketSize);
+	m_jetTree->Branch("recoPy", &row.recoPy, "recoPy/D", basketSize);
+	m_jetTree->Branch("recoPz", &row.recoPz, "recoPz/D", basketSize);
+	m_jetTree->Branch("kaonTrackEnergyinJet", &row.kaonTrackEnergyinJet, "kaonTrackEnergyinJet/D", basketSize);
+	m_jetTree->Branch("protonTrackEnergyinJet", &row.protonTrackEnergyinJet, "protonTrackEnergyinJet/D", basketSize);
+	for ( int i_obs = 0 ; i_obs < JetResidualBatch::kNResiduals ; ++i_obs )
+	{
+		const std::string name = residualObservables[ i_obs ].name;
+		m_jetTree->Branch( name.c_str() , &row.residuals[ i_obs ] , ( name + "/D" ).c_str() , basketSize );
+	}
+}
+
+void EventTreeWriter::fill()
+{
+	if ( m_settings.flatArrays )
+	{
+		// the vectors are filled together, the shortest one bounds what is read from every array
+		for ( FlatArrayGroup &group : m_flatArrayGroups )
+		{
+			std::size_t count = ( group.floatVectors.empty() ? group.intVectors.front()->size() : group.floatVectors.front()->size() );
+			for ( const floatVector *vector : group.floatVectors ) count = std::min( count , vector->size() );
+			for ( const IntVector *vector : group.intVectors ) count = std::min( count , vector->size() );
+			group.count = count;
+			for ( unsigned int i_vector = 0 ; i_vector < group.floatVectors.size() ; ++i_vector )
+			{
+				group.floatBranches[ i_vector ]->SetAddress( count > 0 ? const_cast<float*>( group.floatVectors[ i_vector ]->data() ) : &m_emptyFloat );
+			}
+			for ( unsigned int i_vector = 0 ; i_vector < group.intVectors.size() ; ++i_vector )
+			{
+				group.intBranches[ i_vector ]->SetAddress( count > 0 ? const_cast<int*>( group.intVectors[ i_vector ]->data() ) : &m_emptyInt );
+			}
+		}
+	}
+	m_eventEntry = m_tree->GetEntries();
+	m_tree->Fill();
+	if ( m_jetTree == NULL ) return;
+	for ( const EventResult::JetRecord &jetRecord : m_result->jetRecords )
+	{
+		m_jetRow = jetRecord;
+		m_jetTree->Fill();
+	}
+}
@@ -0,0 +1,114 @@
+#include "GaussianCoreFitter.h"
+#include <algorithm>
+#include <cmath>
+
+void GaussianCoreFitter::setBins( const std::vector<double> &centers , const std::vector<double> &contents , const std::vector<double> &errors )
+{
+	m_centers = centers;
+	m_contents = contents;
+	m_errors = errors;
+}
+
+bool GaussianCoreFitter::fitWindow( double fitMin , double fitMax , Result &result ) const
+{
+	// ln( y ) = a + b * u + c * u^2 with u = x - x0, normal equations summed in one pass
+	const double x0 = 0.5 * ( fitMin + fitMax );
+	double s[ 5 ]{};
+	double t[ 3 ]{};
+	int nBins = 0;
+	for ( unsigned int i_bin = 0 ; i_bin < m_centers.size() ; ++i_bin )
+	{
+		const double x = m_centers[ i_bin ];
+		const double y = m_contents[ i_bin ];
+		const double error = m_errors[ i_bin ];
+		if ( x < fitMin || x > fitMax || !( y > 0.0 ) || !( error > 0.0 ) ) continue;
+		const double weight = ( y * y ) / ( error * error );
+		const double u = x - x0;
+		const double logY = std::log( y );
+		double power = weight;
+		for ( int i = 0 ; i < 5 ; ++i )
+		{
+			s[ i ] += power;
+			if ( i < 3 ) t[ i ] += power * logY;
+			power *= u;
+		}
+		++nBins;
+	}
+	if ( nBins < 3 ) return false;
+
+	// inverse of the symmetric matrix ( s0 s1 s2 ; s1 s2 s3 ; s2 s3 s4 ) is the covariance of ( a , b , c )
+	const double c00 = s[ 2 ] * s[ 4 ] - s[ 3 ] * s[ 3 ];
+	const double c01 = s[ 2 ] * s[ 3 ] - s[ 1 ] * s[ 4 ];
+	const double c02 = s[ 1 ] * s[ 3 ] - s[ 2 ] * s[ 2 ];
+	const double c11 = s[ 0 ] * s[ 4 ] - s[ 2 ] * s[ 2 ];
+	const double c12 = s[ 1 ] * s[ 2 ] - s[ 0 ] * s[ 3 ];
+	const double c22 = s[ 0 ] * s[ 2 ] - s[ 1 ] * s[ 1 ];
+	const double determinant = s[ 0 ] * c00 + s[ 1 ] * c01 + s[ 2 ] * c02;
+	if ( !( std::fabs( determinant ) > 0.0 ) ) return false;
+	const double a = ( c00 * t[ 0 ] + c01 * t[ 1 ] + c02 * t[ 2 ] ) / determinant;
+	const double b = ( c01 * t[ 0 ] + c11 * t[ 1 ] + c12 * t[ 2 ] ) / determinant;
+	const double c = ( c02 * t[ 0 ] + c12 * t[ 1 ] + c22 * t[ 2 ] ) / determinant;
+	if ( !( c < 0.0 ) ) return false;
+
+	result.sigma = std::sqrt( -0.5 / c );
+	result.mean = x0 - 0.5 * b / c;
+	result.constant = std::exp( a - 0.25 * b * b / c );
+
+	// mean = x0 - b / 2c , sigma = ( -2c )^( -1/2 )
+	const double dMean_db = -0.5 / c;
+	const double dMean_dc = 0.5 * b / ( c * c );
+	const double dSigma_dc = result.sigma * result.sigma * result.sigma;
+	result.meanError = std::sqrt( std::max( ( dMean_db * dMean_db * c11 + 2.0 * dMean_db * dMean_dc * c12 + dMean_dc * dMean_dc * c22 ) / determinant , 0.0 ) );
+	result.sigmaError = std::sqrt( std::max( dSigma_dc * dSigma_dc * c22 / determinant , 0.0 ) );
+
+	result.chi2 = 0.0;
+	for ( unsigned int i_bin = 0 ; i_bin < m_centers.size() ; ++i_bin )
+	{
+		const double x = m_centers[ i_bin ];
+		const double y = m_contents[ i_bin ];
+		const double error = m_errors[ i_bin ];
+		if ( x < fitMin || x > fitMax || !( y > 0.0 ) || !( error > 0.0 ) ) continue;
+		const double pull = ( x - result.mean ) / result.sigma;
+		const double residual = ( y - result.constant * std::exp( -0.5 * pull * pull ) ) / error;
+		result.chi2 += residual * residual;
+	}
+	result.ndf = nBins - 3;
+	result.fitMin = fitMin;
+	result.fitMax = fitMax;
+	return true;
+}
+
+GaussianCoreFitter::Result GaussianCoreFitter::fit( double fitMin , double fitMax , double fitRange ) const
+{
+	Result result;
+	result.fitRange = fitRange;
+	for ( ; ; )
+	{
+		Result current;
+		current.fitRange = fitRange;
+		current.nPasses = result.nPasses;
+		double windowMin = fitMin;
+		double windowMax = fitMax;
+		for ( int i_pass = 0 ; i_pass < kMaxPassesPerRange ; ++i_pass )
+		{
+			const double previousMean = current.mean;
+			const double previousSigma = current.sigma;
+			++current.nPasses;
+			current.valid = fitWindow( windowMin , windowMax , current );
+			if ( !current.valid ) break;
+			windowMin = current.mean - fitRange * current.sigma;
+			windowMax = current.mean + fitRange * current.sigma;
+			if ( i_pass > 0 && std::fabs( current.mean - previousMean ) < 1.0e-4 * current.sigma && std::fabs( current.sigma - previousSigma ) < 1.0e-4 * current.sigma ) break;
+		}
+		if ( !current.valid )
+		{
+			result.nPasses = current.nPasses;
+			return result;
+		}
+		result = current;
+		if ( result.ndf <= 0 || result.chi2 / result.ndf <= kMaxReducedChi2 || fitRange < kMinFitRange - 1.0e-6 ) return result;
+		fitMin = result.fitMin;
+		fitMax = result.fitMax;
+		fitRange -= kFitRangeStep;
+	}
+}
@@ -0,0 +1,92 @@
+#include "JetCovarianceBuilder.h"
+#include <cmath>
+
+namespace
+{
+	// row and column of the lower triangle elements of a 4x4 matrix, ReconstructedParticle::getCovMatrix() order
+	const int kRow[ 10 ]{ 0 , 1 , 1 , 2 , 2 , 2 , 3 , 3 , 3 , 3 };
+	const int kColumn[ 10 ]{ 0 , 0 , 1 , 0 , 1 , 2 , 0 , 1 , 2 , 3 };
+}
+
+void JetCovarianceBuilder::clear()
+{
+	m_omega.clear();
+	for ( std::vector<double> &helixCovariance : m_helixCovariance ) helixCovariance.clear();
+	m_fourMomentum.fill( 0.0 );
+	m_covariance.fill( 0.0 );
+	m_covMatrix.fill( 0.0 );
+	m_nNeutrals = 0;
+}
+
+void JetCovarianceBuilder::addParticle( const EVENT::ReconstructedParticle *pfo )
+{
+	const EVENT::TrackVec &tracks = pfo->getTracks();
+	if ( tracks.empty() )
+	{
+		for ( int i = 0 ; i < 3 ; ++i ) m_fourMomentum[ i ] += pfo->getMomentum()[ i ];
+		m_fourMomentum[ 3 ] += pfo->getEnergy();
+		const EVENT::FloatVec &covMatrix = pfo->getCovMatrix();
+		if ( covMatrix.size() >= 10 )
+		{
+			for ( int i = 0 ; i < 10 ; ++i ) m_covariance[ i ] += covMatrix[ i ];
+		}
+		++m_nNeutrals;
+		return;
+	}
+	for ( const EVENT::Track *track : tracks )
+	{
+		// lower triangle of ( d0 , phi , omega , z0 , tanLambda ), a track without covariance adds its momentum only
+		const EVENT::FloatVec &covMatrix = track->getCovMatrix();
+		const bool hasCovariance = covMatrix.size() >= 15;
+		m_omega.push_back( track->getOmega() );
+		m_helixCovariance[ kPhiPhi ].push_back( hasCovariance ? covMatrix[ 2 ] : 0.0 );
+		m_helixCovariance[ kOmegaPhi ].push_back( hasCovariance ? covMatrix[ 4 ] : 0.0 );
+		m_helixCovariance[ kOmegaOmega ].push_back( hasCovariance ? covMatrix[ 5 ] : 0.0 );
+		m_helixCovariance[ kTanLambdaPhi ].push_back( hasCovariance ? covMatrix[ 11 ] : 0.0 );
+		m_helixCovariance[ kTanLambdaOmega ].push_back( hasCovariance ? covMatrix[ 12 ] : 0.0 );
+		m_helixCovariance[ kTanLambdaTanLambda ].push_back( hasCovariance ? covMatrix[ 14 ] : 0.0 );
+	}
+}
+
+void JetCovarianceBuilder::finish( const TrackMomentumBatch &momenta )
+{
+	const std::size_t nTRKs = m_omega.size();
+	for ( std::size_t i_trk = 0 ; i_trk < nTRKs ; ++i_trk )
+	{
+		const double px = momenta.component( TrackMomentumBatch::kPx , i_trk );
+		const double py = momenta.component( TrackMomentumBatch::kPy , i_trk );
+		const double pz = momenta.component( TrackMomentumBatch::kPz , i_trk );
+		const double energy = momenta.component( TrackMomentumBatch::kE , i_trk );
+		const double omega = m_omega[ i_trk ];
+		m_fourMomentum[ 0 ] += px;
+		m_fourMomentum[ 1 ] += py;
+		m_fourMomentum[ 2 ] += pz;
+		m_fourMomentum[ 3 ] += energy;
+
+		// pT = eB / | omega |, so d( px , py , pz ) / d omega = -( px , py , pz ) / omega
+		const double pt = std::sqrt( px * px + py * py );
+		const double p2 = px * px + py * py + pz * pz;
+		const double jacobian[ 4 ][ 3 ]{	{ -py , -px / omega , 0.0 } ,
+							{ px , -py / omega , 0.0 } ,
+							{ 0.0 , -pz / omega , pt } ,
+							{ 0.0 , -p2 / ( omega * energy ) , pz * pt / energy } };
+		const double helixCovariance[ 3 ][ 3 ]{	{ m_helixCovariance[ kPhiPhi ][ i_trk ] , m_helixCovariance[ kOmegaPhi ][ i_trk ] , m_helixCovariance[ kTanLambdaPhi ][ i_trk ] } ,
+							{ m_helixCovariance[ kOmegaPhi ][ i_trk ] , m_helixCovariance[ kOmegaOmega ][ i_trk ] , m_helixCovariance[ kTanLambdaOmega ][ i_trk ] } ,
+							{ m_helixCovariance[ kTanLambdaPhi ][ i_trk ] , m_helixCovariance[ kTanLambdaOmega ][ i_trk ] , m_helixCovariance[ kTanLambdaTanLambda ][ i_trk ] } };
+		double jacobianCovariance[ 4 ][ 3 ]{};
+		for ( int i = 0 ; i < 4 ; ++i )
+		{
+			for ( int j = 0 ; j < 3 ; ++j )
+			{
+				for ( int k = 0 ; k < 3 ; ++k ) jacobianCovariance[ i ][ j ] += jacobian[ i ][ k ] * helixCovariance[ k ][ j ];
+			}
+		}
+		for ( int i_element = 0 ; i_element < 10 ; ++i_element )
+		{
+			const int row = kRow[ i_element ];
+			const int column = kColumn[ i_element ];
+			for ( int k = 0 ; k < 3 ; ++k ) m_covariance[ i_element ] += jacobianCovariance[ row ][ k ] * jacobian[ column ][ k ];
+		}
+	}
+	for ( int i_element = 0 ; i_element < 10 ; ++i_element ) m_covMatrix[ i_element ] = m_covariance[ i_element ];
+}
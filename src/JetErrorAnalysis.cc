@@ -1,12 +1,21 @@
 #include "JetErrorAnalysis.h"
+#include "AnalysisLogging.h"
+#include "PartialHistogramTree.h"
+#include "ResidualHistogramOutput.h"
+#include "ResidualObservables.h"
+#include "MarlinUtil.h"
 #include <stdlib.h>
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include "TH1F.h"
 #include "TH2F.h"
 #include "TF1.h"
+#include "TList.h"
 #include "TPaveStats.h"
+#include "TROOT.h"
 
 
 // ----- include for verbosity dependend logging ---------
@@ -26,6 +35,86 @@ using namespace std ;
 
 JetErrorAnalysis aJetErrorAnalysis ;
 
+namespace
+{
+	/*
+	* TrueJet_Parser for the worker slots other than the first, which uses the processor itself
+	*/
+	class SlotTrueJetParser : public TrueJet_Parser
+	{
+		public:
+
+			SlotTrueJetParser( const EventContext &eventContext )
+			{
+				_trueJetCollectionName = eventContext.collectionName( EventContext::kTrueJets );
+				_finalColourNeutralCollectionName = eventContext.collectionName( EventContext::kFinalColourNeutrals );
+				_initialColourNeutralCollectionName = eventContext.collectionName( EventContext::kInitialColourNeutrals );
+				_trueJetPFOLink = eventContext.collectionName( EventContext::kTrueJetPFOLink );
+				_trueJetMCParticleLink = eventContext.collectionName( EventContext::kTrueJetMCParticleLink );
+				_finalElementonLink = eventContext.collectionName( EventContext::kFinalElementonLink );
+				_initialElementonLink = eventContext.collectionName( EventContext::kInitialElementonLink );
+				_finalColourNeutralLink = eventContext.collectionName( EventContext::kFinalColourNeutralLink );
+				_initialColourNeutralLink = eventContext.collectionName( EventContext::kInitialColourNeutralLink );
+				m_recoMCTruthLink = eventContext.collectionName( EventContext::kRecoMCTruthLink );
+			}
+
+			std::string get_recoMCTruthLink()
+			{
+				return m_recoMCTruthLink;
+			}
+
+		private:
+
+			std::string			m_recoMCTruthLink{};
+	};
+}
+
+namespace
+{
+	// tracks per TrackMomentumBatch in JetErrorAnalysis::hasPIDTrackEnergy
+	const int kPIDTrackChunk = 64;
+
+	// relative margin of the event track energy over the jet track energy, far above the rounding of the sums
+	const double kPIDTrackEnergyMargin = 1.0 + 1e-9;
+
+	/*
+	* Residuals of one jet of a computed batch
+	*/
+	EventResult::JetResiduals batchJetResiduals( const JetResidualBatch &residualBatch , std::size_t i_jet )
+	{
+		EventResult::JetResiduals jetResiduals{};
+		for ( int i_obs = 0 ; i_obs < JetResidualBatch::kNResiduals ; ++i_obs )
+		{
+			jetResiduals[ i_obs ] = residualBatch.residual( static_cast<JetResidualBatch::Residual>( i_obs ) , i_jet );
+		}
+		return jetResiduals;
+	}
+
+	/*
+	* Copies the residuals of a jet into the eventTree vectors of the event record
+	*/
+	void appendJetResiduals( const EventResult::JetResiduals &jetResiduals , EventResult &result )
+	{
+		result.jetResiduals.push_back( jetResiduals );
+		for ( int i_obs = 0 ; i_obs < JetResidualBatch::kNResiduals ; ++i_obs )
+		{
+			result.residuals[ i_obs ].push_back( jetResiduals[ i_obs ] );
+		}
+	}
+}
+
+/*
+* Per-thread state of processEventConcurrent
+*/
+struct JetErrorAnalysis::WorkerSlot
+{
+	EventContext				eventContext{};
+	TrueJet_Parser				*trueJet{};
+	std::unique_ptr<TrueJet_Parser>		slotTrueJet{};
+	EventResult				result{};
+	EventResult::Capacity			resultCapacity{};
+};
+
 JetErrorAnalysis::JetErrorAnalysis() : Processor("JetErrorAnalysis"),
 m_Bfield(0.f),
 c(0.),
@@ -39,31 +128,6 @@ m_nRun(0),
 m_nEvt(0),
 m_nRunSum(0),
 m_nEvtSum(0),
-m_nTrueJets(0),
-m_nTrueLeptons(0),
-m_nRecoJets(0),
-m_nRecoLeptons(0),
-m_HDecayMode(0),
-m_nSLDecayBHadron(0),
-m_nSLDecayCHadron(0),
-m_nSLDecayTotal(0),
-m_trueKaonEnergyTotal(0.0),
-m_trueProtonEnergyTotal(0.0),
-m_pionTrackEnergyTotal(0.0),
-m_protonTrackEnergyTotal(0.0),
-m_kaonTrackEnergyTotal(0.0),
-n_ResidualPx(0.0),
-n_ResidualPy(0.0),
-n_ResidualPz(0.0),
-n_ResidualE(0.0),
-n_ResidualTheta(0.0),
-n_ResidualPhi(0.0),
-n_NormalizedResidualPx(0.0),
-n_NormalizedResidualPy(0.0),
-n_NormalizedResidualPz(0.0),
-n_NormalizedResidualE(0.0),
-n_NormalizedResidualTheta(0.0),
-n_NormalizedResidualPhi(0.0),
 m_pTFile(NULL),
 m_pTTree(NULL)
 {
@@ -133,12 +197,96 @@ m_pTTree(NULL)
 					std::string("MarlinTrkTracksProton")
 				);
 
+	registerOptionalParameter(	"Bfield",
+					"magnetic field [T] used to convert the track curvature to momentum; default: Bz at the origin of the DD4hep geometry, this value if no geometry is loaded",
+					m_Bfield,
+					float(3.5)
+				);
+
+	registerOptionalParameter(	"trackSpecies",
+					"mass hypotheses of the PFO tracks as PDG, mass [GeV] and track collection per species, a track takes the first species whose collection lists it and the pion mass otherwise; default: the proton and kaon collections above",
+					m_trackSpeciesParameter,
+					StringVec()
+				);
+
 	registerProcessorParameter(	"outputFilename",
 					"name of output file",
 					m_outputFile,
 					std::string("")
 				);
 
+	registerProcessorParameter(	"outputCompression",
+					"compression algorithm of the output file: default, none, ZLIB, LZMA, LZ4 or ZSTD",
+					m_treeSettings.compression,
+					std::string("default")
+				);
+
+	registerProcessorParameter(	"outputCompressionLevel",
+					"compression level (1-9) used with outputCompression",
+					m_treeSettings.compressionLevel,
+					int(4)
+				);
+
+	registerProcessorParameter(	"outputBasketSize",
+					"basket size in bytes of every eventTree branch",
+					m_treeSettings.basketSize,
+					int(32000)
+				);
+
+	registerProcessorParameter(	"outputAutoFlush",
+					"AutoFlush of eventTree: > 0 entries, < 0 bytes per cluster",
+					m_treeSettings.autoFlush,
+					int(-30000000)
+				);
+
+	registerProcessorParameter(	"flatArrays",
+					"write per-jet and per-track quantities as count-indexed leaf arrays instead of std::vector branches",
+					m_treeSettings.flatArrays,
+					bool(false)
+				);
+
+	registerProcessorParameter(	"writeJetTree",
+					"write jetTree with one entry per matched pair of true and reconstructed jet",
+					m_treeSettings.jetTree,
+					bool(true)
+				);
+
+	registerProcessorParameter(	"lazyTrueJetParsing",
+					"read the true jet types from the TrueJets collection first and call TrueJet_Parser::getall only if the event has as many true hadronic jets as reconstructed jets",
+					m_lazyTrueJetParsing,
+					bool(true)
+				);
+
+	registerProcessorParameter(	"skipFillOnReject",
+					"do not write events rejected by the pre-selection to eventTree; rejected are events without as many true hadronic as reconstructed jets ( with lazyTrueJetParsing ) and events whose kaon / proton tracks cannot reach minKaonTrackEnergy / minProtonTrackEnergy of any cut configuration",
+					m_skipFillOnReject,
+					bool(false)
+				);
+
+	registerProcessorParameter(	"vectorizedTrackMomenta",
+					"compute the track four-momenta of a jet in one batch with a polynomial sincos ( agrees with std::cos / std::sin to a few ulp ); false for the std::cos / std::sin reference",
+					m_vectorizedTrackMomenta,
+					bool(true)
+				);
+
+	registerProcessorParameter(	"rebuildJetCovariance",
+					"take the reconstructed jet four-momentum and covariance for the residuals from the PFOs of the reference jet, with the tracks under the mass hypothesis of their species and their helix covariances propagated, instead of from RecoJetCollection; the recoE / recoPx / recoPy / recoPz of jetTree are then those of the rebuilt jet",
+					m_rebuildJetCovariance,
+					bool(false)
+				);
+
+	registerProcessorParameter(	"writeStatisticsTree",
+					"write the stage timings and counters printed at the end of the job as processorStatistics tree",
+					m_writeStatisticsTree,
+					bool(false)
+				);
+
+	registerProcessorParameter(	"eventSummaryInterval",
+					"print the per-event banner for every n-th event only, 0 to switch it off",
+					m_eventSummaryInterval,
+					int(100)
+				);
+
 	registerProcessorParameter(	"HistogramsName",
 					"name of histograms",
 					m_histName,
@@ -151,6 +299,18 @@ m_pTTree(NULL)
 					int(1)
 				);
 
+	registerProcessorParameter(	"nHistogramBins",
+					"maximum number of bins of the residual histograms, the range is chosen from the data at the end of the job",
+					m_nHistogramBins,
+					int(200)
+				);
+
+	registerProcessorParameter(	"rootFitCrossCheck",
+					"repeat the Gaussian core fit of every histogram with a ROOT fit and print both",
+					m_rootFitCrossCheck,
+					bool(false)
+				);
+
 	registerProcessorParameter(	"minKaonTrackEnergy",
 					"min Energy of Kaons Tracks for histograming",
 					m_minKaonTrackEnergy,
@@ -163,6 +323,24 @@ m_pTTree(NULL)
 					float(0.0)
 				);
 
+	registerOptionalParameter(	"cutConfigurations",
+					"further working points filled in the same pass, as name, colour, min kaon and min proton track energy per configuration; their histograms are named h_<observable>_<name>, the eventTree residuals stay those of minKaonTrackEnergy / minProtonTrackEnergy",
+					m_cutConfigurationParameter,
+					StringVec()
+				);
+
+	registerProcessorParameter(	"writePartialHistograms",
+					"write the raw residual histograms and jet counts as partialResidualHistograms tree instead of the normalized, fitted histograms; the partial results of many jobs are merged and fitted once with mergeResidualHistograms",
+					m_writePartialHistograms,
+					bool(false)
+				);
+
+	registerProcessorParameter(	"nConcurrentSlots",
+					"number of worker slots for drivers calling processEventConcurrent from several threads",
+					m_nConcurrentSlots,
+					int(1)
+				);
+
 
 	// Inputs: True jets (as a recoparticle, will be the sum of the _reconstructed particles_
 	// created by the true particles in each true jet, in the RecoMCTruthLink sense.
@@ -235,119 +413,184 @@ m_pTTree(NULL)
 }
 
 
+JetErrorAnalysis::~JetErrorAnalysis() = default;
+
+
 void JetErrorAnalysis::init()
 {
 
 	streamlog_out(DEBUG6) << "   init called  " << std::endl ;
 
 	// usually a good idea to
-//	m_Bfield = MarlinUtil::getBzAtOrigin();
-	m_Bfield = 3.5;
-	c = 2.99792458e8;
-	mm2m = 1e-3;
-	eV2GeV = 1e-9;
-	eB = m_Bfield * c * mm2m * eV2GeV;
 	printParameters() ;
 
+	configureMagneticField();
+
 	m_pion_mass = 0.13957018;
 	m_proton_mass = 0.938272088;
 	m_kaon_mass = 0.493677;
+	configureTrackSpecies();
+	configureCutConfigurations();
 
 	m_nRun = 0 ;
 	m_nEvt = 0 ;
 
+	if ( m_nConcurrentSlots < 1 ) m_nConcurrentSlots = 1;
+	if ( m_nConcurrentSlots > 1 ) ROOT::EnableThreadSafety();
+	m_eventLogging = ( m_nConcurrentSlots == 1 );
+	m_workerSlots.clear();
+	for ( int i_slot = 0 ; i_slot < m_nConcurrentSlots ; ++i_slot )
+	{
+		std::unique_ptr<WorkerSlot> workerSlot( new WorkerSlot );
+		configureEventContext( workerSlot->eventContext );
+		workerSlot->eventContext.setEventLogging( m_eventLogging );
+		if ( i_slot == 0 )
+		{
+			workerSlot->trueJet = this;
+		}
+		else
+		{
+			workerSlot->slotTrueJet.reset( new SlotTrueJetParser( workerSlot->eventContext ) );
+			workerSlot->trueJet = workerSlot->slotTrueJet.get();
+		}
+		m_workerSlots.push_back( std::move( workerSlot ) );
+	}
+	m_pendingResults.clear();
+	m_spareResults.clear();
+	m_nextCommitSequence = 0;
+	m_nReadEvents = 0;
+	m_commitStatistics.clear();
+
 	m_pTFile = new TFile(m_outputFile.c_str(),"recreate");
 
-	m_pTTree = new TTree("eventTree","eventTree");
-	m_pTTree->SetDirectory(m_pTFile);
-	m_pTTree->Branch("run", &m_nRun, "run/I");
-	m_pTTree->Branch("event", &m_nEvt, "event/I");
-	m_pTTree->Branch("nTrueJets",&m_nTrueJets,"nTrueJets/I") ;
-	m_pTTree->Branch("nTrueLeptons",&m_nTrueLeptons,"nTrueLeptons/I") ;
-	m_pTTree->Branch("nRecoJets",&m_nRecoJets,"nRecoJets/I") ;
-	m_pTTree->Branch("nRecoLeptons",&m_nRecoLeptons,"nRecoLeptons/I") ;
-	m_pTTree->Branch("HDecayMode",&m_HDecayMode,"HDecayMode/I") ;
-	m_pTTree->Branch("nSLDecayBHadron",&m_nSLDecayBHadron,"nSLDecayBHadron/I") ;
-	m_pTTree->Branch("nSLDecayCHadron",&m_nSLDecayCHadron,"nSLDecayCHadron/I") ;
-	m_pTTree->Branch("nSLDecayTotal",&m_nSLDecayTotal,"nSLDecayTotal/I") ;
-	m_pTTree->Branch("trueKaonEnergy",&m_trueKaonEnergy) ;
-	m_pTTree->Branch("trueKaonEnergyTotal",&m_trueKaonEnergyTotal,"trueKaonEnergyTotal/F") ;
-	m_pTTree->Branch("trueProtonEnergy",&m_trueProtonEnergy) ;
-	m_pTTree->Branch("trueProtonEnergyTotal",&m_trueProtonEnergyTotal,"trueProtonEnergyTotal/F") ;
-	m_pTTree->Branch("pionTrackEnergy",&m_pionTrackEnergy) ;
-	m_pTTree->Branch("pionTrackEnergyTotal",&m_pionTrackEnergyTotal,"pionTrackEnergyTotal/F") ;
-	m_pTTree->Branch("protonTrackEnergy",&m_protonTrackEnergy) ;
-	m_pTTree->Branch("protonTrackEnergyinJet",&m_ProtonTrackEnergyinJet) ;
-	m_pTTree->Branch("protonTrackEnergyTotal",&m_protonTrackEnergyTotal,"protonTrackEnergyTotal/F") ;
-	m_pTTree->Branch("kaonTrackEnergy",&m_kaonTrackEnergy) ;
-	m_pTTree->Branch("kaonTrackEnergyinJet",&m_KaonTrackEnergyinJet) ;
-	m_pTTree->Branch("kaonTrackEnergyTotal",&m_kaonTrackEnergyTotal,"kaonTrackEnergyTotal/F") ;
-	m_pTTree->Branch("ResidualPx",&m_ResidualPx) ;
-	m_pTTree->Branch("ResidualPy",&m_ResidualPy) ;
-	m_pTTree->Branch("ResidualPz",&m_ResidualPz) ;
-	m_pTTree->Branch("ResidualE",&m_ResidualE) ;
-	m_pTTree->Branch("ResidualTheta",&m_ResidualTheta) ;
-	m_pTTree->Branch("ResidualPhi",&m_ResidualPhi) ;
-	m_pTTree->Branch("NormalizedResidualPx",&m_NormalizedResidualPx) ;
-	m_pTTree->Branch("NormalizedResidualPy",&m_NormalizedResidualPy) ;
-	m_pTTree->Branch("NormalizedResidualPz",&m_NormalizedResidualPz) ;
-	m_pTTree->Branch("NormalizedResidualE",&m_NormalizedResidualE) ;
-	m_pTTree->Branch("NormalizedResidualTheta",&m_NormalizedResidualTheta) ;
-	m_pTTree->Branch("NormalizedResidualPhi",&m_NormalizedResidualPhi) ;
-	m_pTTree->Branch("trueJetType",&m_trueJetType) ;
-	m_pTTree->Branch("trueJetFlavour",&m_trueJetFlavour) ;
-	h_ResidualPx = new TH1F( m_histName.c_str() , ( m_histName + "; _{}p_{x,jet}^{REC} - p_{x,jet}^{MC} [GeV]; Normalized Entries / 0.1" ).c_str() , 200 , -10.0 , 10.0 ); n_ResidualPx = 0;
-	h_ResidualPy = new TH1F( m_histName.c_str() , ( m_histName + "; _{}p_{y,jet}^{REC} - p_{y,jet}^{MC} [GeV]; Normalized Entries / 0.1" ).c_str() , 200 , -10.0 , 10.0 ); n_ResidualPy = 0;
-	h_ResidualPz = new TH1F( m_histName.c_str() , ( m_histName + "; _{}p_{z,jet}^{REC} - p_{z,jet}^{MC} [GeV]; Normalized Entries / 0.1" ).c_str() , 200 , -10.0 , 10.0 ); n_ResidualPz = 0;
-	h_ResidualE = new TH1F( m_histName.c_str() , ( m_histName + "; _{}E_{jet}^{REC} - E_{jet}^{MC} [GeV]; Normalized Entries / 0.1" ).c_str() , 200 , -10.0 , 10.0 ); n_ResidualE = 0;
-	h_ResidualTheta = new TH1F( m_histName.c_str() , ( m_histName + "; _{}#theta_{jet}^{REC} - #theta_{jet}^{MC} [rad]; Normalized Entries / 0.1" ).c_str() , 20 * 3.14159265 , -3.14159265 , 3.14159265 ); n_ResidualTheta = 0;
-	h_ResidualPhi = new TH1F( m_histName.c_str() , ( m_histName + "; _{}#phi_{jet}^{REC} - #phi_{jet}^{MC} [rad]; Normalized Entries / 0.1" ).c_str() , 20 * 3.14159265 , -3.14159265 , 3.14159265 ); n_ResidualPhi = 0;
-	h_NormalizedResidualPx = new TH1F( m_histName.c_str() , ( m_histName + "; (_{}p_{x,jet}^{REC} - p_{x,jet}^{MC}) / #sigma_{p_{x,jet}}; Normalized Entries / 0.1" ).c_str() , 200 , -10.0 , 10.0 ); n_NormalizedResidualPx = 0;
-	h_NormalizedResidualPy = new TH1F( m_histName.c_str() , ( m_histName + "; (_{}p_{y,jet}^{REC} - p_{y,jet}^{MC}) / #sigma_{p_{y,jet}}; Normalized Entries / 0.1" ).c_str() , 200 , -10.0 , 10.0 ); n_NormalizedResidualPy = 0;
-	h_NormalizedResidualPz = new TH1F( m_histName.c_str() , ( m_histName + "; (_{}p_{z,jet}^{REC} - p_{z,jet}^{MC}) / #sigma_{p_{z,jet}}; Normalized Entries / 0.1" ).c_str() , 200 , -10.0 , 10.0 ); n_NormalizedResidualPz = 0;
-	h_NormalizedResidualE = new TH1F( m_histName.c_str() , ( m_histName + "; (_{}E_{jet}^{REC} - E_{jet}^{MC}) / #sigma_{E_{jet}}; Normalized Entries / 0.1" ).c_str() , 200 , -10.0 , 10.0 ); n_NormalizedResidualE = 0;
-	h_NormalizedResidualTheta = new TH1F( m_histName.c_str() , ( m_histName + "; (_{}#theta_{jet}^{REC} - #theta_{jet}^{MC}) / #sigma_{#theta_{jet}}; Normalized Entries / 0.1" ).c_str() , 200 , -10.0 , 10.0 ); n_NormalizedResidualTheta = 0;
-	h_NormalizedResidualPhi = new TH1F( m_histName.c_str() , ( m_histName + "; (_{}#phi_{jet}^{REC} - #phi_{jet}^{MC}) / #sigma_{#phi_{jet}}; Normalized Entries / 0.1" ).c_str() , 200 , -10.0 , 10.0 ); n_NormalizedResidualPhi = 0;
+	int compression = 0;
+	if ( !EventTreeWriter::compressionSettings( m_treeSettings.compression , m_treeSettings.compressionLevel , compression ) && m_treeSettings.compression != "default" )
+	{
+		streamlog_out(WARNING) << "	Unknown outputCompression \"" << m_treeSettings.compression << "\", use none, ZLIB, LZMA, LZ4 or ZSTD; keeping the default compression" << std::endl;
+	}
+	m_pTTree = m_eventTreeWriter.book( m_pTFile , m_treeSettings , m_eventResult , m_nRun , m_nEvt );
 
 }
 
+void JetErrorAnalysis::configureEventContext( EventContext &eventContext )
+{
+	eventContext.setCollectionName( EventContext::kRecoJets , m_recoJetCollectionName );
+	eventContext.setCollectionName( EventContext::kReferenceJets , m_referenceJetCollection );
+	eventContext.setCollectionName( EventContext::kMCParticles , _MCParticleColllectionName );
+	eventContext.setCollectionName( EventContext::kRecoParticles , _recoParticleCollectionName );
+	eventContext.setCollectionName( EventContext::kRecoMCTruthLink , _recoMCTruthLink );
+	eventContext.setCollectionName( EventContext::kTracks , m_MarlinTrkTracks );
+	eventContext.setCollectionName( EventContext::kTrueJets , _trueJetCollectionName );
+	eventContext.setCollectionName( EventContext::kFinalColourNeutrals , _finalColourNeutralCollectionName );
+	eventContext.setCollectionName( EventContext::kInitialColourNeutrals , _initialColourNeutralCollectionName );
+	eventContext.setCollectionName( EventContext::kTrueJetPFOLink , _trueJetPFOLink );
+	eventContext.setCollectionName( EventContext::kTrueJetMCParticleLink , _trueJetMCParticleLink );
+	eventContext.setCollectionName( EventContext::kFinalElementonLink , _finalElementonLink );
+	eventContext.setCollectionName( EventContext::kInitialElementonLink , _initialElementonLink );
+	eventContext.setCollectionName( EventContext::kFinalColourNeutralLink , _finalColourNeutralLink );
+	eventContext.setCollectionName( EventContext::kInitialColourNeutralLink , _initialColourNeutralLink );
+	eventContext.trackClassifier().setSpecies( m_trackSpecies , eB );
+	eventContext.trackClassifier().setVectorized( m_vectorizedTrackMomenta );
+}
+
+void JetErrorAnalysis::configureMagneticField()
+{
+	// the field is read once; every track momentum uses the cached eB
+	std::string source = "steering file";
+	if ( !parameterSet( "Bfield" ) )
+	{
+		const float defaultBfield = m_Bfield;
+		source = "DD4hep geometry";
+		try
+		{
+			m_Bfield = MarlinUtil::getBzAtOrigin();
+		}
+		catch ( const std::exception &e )
+		{
+			streamlog_out(WARNING) << "	Cannot read the magnetic field from the DD4hep geometry: " << e.what() << std::endl;
+			m_Bfield = 0.f;
+		}
+		if ( m_Bfield == 0.f )
+		{
+			streamlog_out(WARNING) << "	No magnetic field in the DD4hep geometry, using Bfield = " << defaultBfield << " T; load the geometry or set Bfield in the steering file" << std::endl;
+			m_Bfield = defaultBfield;
+			source = "default";
+		}
+	}
+	c = 2.99792458e8;
+	mm2m = 1e-3;
+	eV2GeV = 1e-9;
+	eB = m_Bfield * c * mm2m * eV2GeV;
+	streamlog_out(MESSAGE) << "	Bz = " << m_Bfield << " T ( " << source << " )" << std::endl;
+}
+
+void JetErrorAnalysis::configureCutConfigurations()
+{
+	// configuration 0 is the one of the single-cut steering parameters, with the historic histogram names
+	m_residualHistograms.clear();
+	m_residualHistograms.push_back( ResidualHistogramSet( m_histName , m_histColour , m_minKaonTrackEnergy , m_minProtonTrackEnergy , "" ) );
+	if ( m_cutConfigurationParameter.size() % 4 != 0 ) streamlog_out(WARNING) << "	cutConfigurations needs name, colour, min kaon and min proton track energy of every configuration, ignoring the last " << m_cutConfigurationParameter.size() % 4 << " value(s)" << std::endl;
+	for ( unsigned int i_par = 0 ; i_par + 3 < m_cutConfigurationParameter.size() ; i_par += 4 )
+	{
+		const std::string &name = m_cutConfigurationParameter[ i_par ];
+		m_residualHistograms.push_back( ResidualHistogramSet( name , std::atoi( m_cutConfigurationParameter[ i_par + 1 ].c_str() ) , std::atof( m_cutConfigurationParameter[ i_par + 2 ].c_str() ) , std::atof( m_cutConfigurationParameter[ i_par + 3 ].c_str() ) , "_" + name ) );
+	}
+	for ( const ResidualHistogramSet &residualHistograms : m_residualHistograms )
+	{
+		streamlog_out(MESSAGE) << "	Cut configuration \"" << residualHistograms.title() << "\" : min kaon track energy = " << residualHistograms.minKaonTrackEnergy() << " GeV , min proton track energy = " << residualHistograms.minProtonTrackEnergy() << " GeV" << std::endl;
+	}
+}
+
+bool JetErrorAnalysis::acceptsJet( double KaonTrackEnergyinJet , double ProtonTrackEnergyinJet ) const
+{
+	for ( const ResidualHistogramSet &residualHistograms : m_residualHistograms )
+	{
+		if ( residualHistograms.accepts( KaonTrackEnergyinJet , ProtonTrackEnergyinJet ) ) return true;
+	}
+	return false;
+}
+
+void JetErrorAnalysis::configureTrackSpecies()
+{
+	m_trackSpecies.assign( 1 , TrackClassifier::Species{ 211 , m_pion_mass , "" } );
+	if ( parameterSet( "trackSpecies" ) )
+	{
+		if ( m_trackSpeciesParameter.size() % 3 != 0 ) streamlog_out(WARNING) << "	trackSpecies needs PDG, mass and collection of every species, ignoring the last " << m_trackSpeciesParameter.size() % 3 << " value(s)" << std::endl;
+		for ( unsigned int i_par = 0 ; i_par + 2 < m_trackSpeciesParameter.size() ; i_par += 3 )
+		{
+			m_trackSpecies.push_back( TrackClassifier::Species{ std::atoi( m_trackSpeciesParameter[ i_par ].c_str() ) , std::atof( m_trackSpeciesParameter[ i_par + 1 ].c_str() ) , m_trackSpeciesParameter[ i_par + 2 ] } );
+		}
+	}
+	else
+	{
+		m_trackSpecies.push_back( TrackClassifier::Species{ 2212 , m_proton_mass , m_MarlinTrkTracksPROTON } );
+		m_trackSpecies.push_back( TrackClassifier::Species{ 321 , m_kaon_mass , m_MarlinTrkTracksKAON } );
+	}
+
+	// pions, kaons and protons have their own eventTree branches, every species is in speciesTrackEnergyTotal
+	m_trackSpeciesOutputs.assign( m_trackSpecies.size() , TrackSpeciesOutput{} );
+	for ( unsigned int i_species = 0 ; i_species < m_trackSpecies.size() ; ++i_species )
+	{
+		TrackSpeciesOutput &output = m_trackSpeciesOutputs[ i_species ];
+		switch ( std::abs( m_trackSpecies[ i_species ].pdg ) )
+		{
+			case 211:
+				output = TrackSpeciesOutput{ &EventResult::pionTrackEnergy , &EventResult::pionTrackEnergyTotal , TrackSpeciesOutput::kNoJetEnergy };
+				break;
+			case 321:
+				output = TrackSpeciesOutput{ &EventResult::kaonTrackEnergy , &EventResult::kaonTrackEnergyTotal , TrackSpeciesOutput::kKaonJetEnergy };
+				break;
+			case 2212:
+				output = TrackSpeciesOutput{ &EventResult::protonTrackEnergy , &EventResult::protonTrackEnergyTotal , TrackSpeciesOutput::kProtonJetEnergy };
+				break;
+		}
+		streamlog_out(MESSAGE) << "	Track species " << i_species << " : PDG " << m_trackSpecies[ i_species ].pdg << " , mass " << m_trackSpecies[ i_species ].mass << " GeV" << ( i_species == 0 ? " , tracks in no collection" : " , collection " + m_trackSpecies[ i_species ].collectionName ) << std::endl;
+	}
+}
+
 void JetErrorAnalysis::Clear()
 {
-	m_nTrueJets = 0;
-	m_nTrueLeptons = 0;
-	m_nTrueLeptons = 0;
-	m_nRecoJets = 0;
-	m_nRecoLeptons = 0;
-	m_HDecayMode = 0;
-	m_nSLDecayBHadron = 0;
-	m_nSLDecayCHadron = 0;
-	m_nSLDecayTotal = 0;
-	m_trueKaonEnergyTotal = 0.0;
-	m_trueKaonEnergy.clear();
-	m_trueProtonEnergyTotal = 0.0;
-	m_trueProtonEnergy.clear();
-	m_pionTrackEnergy.clear();
-	m_pionTrackEnergyTotal = 0.0;
-	m_protonTrackEnergy.clear();
-	m_ProtonTrackEnergyinJet.clear();
-	m_protonTrackEnergyTotal = 0.0;
-	m_kaonTrackEnergy.clear();
-	m_KaonTrackEnergyinJet.clear();
-	m_kaonTrackEnergyTotal = 0.0;
-	m_ResidualPx.clear();
-	m_ResidualPy.clear();
-	m_ResidualPz.clear();
-	m_ResidualE.clear();
-	m_ResidualTheta.clear();
-	m_ResidualPhi.clear();
-	m_NormalizedResidualPx.clear();
-	m_NormalizedResidualPy.clear();
-	m_NormalizedResidualPz.clear();
-	m_NormalizedResidualE.clear();
-	m_NormalizedResidualTheta.clear();
-	m_NormalizedResidualPhi.clear();
-	m_trueJetType.clear();
-	m_trueJetFlavour.clear();
+	m_eventResult.clear();
 }
 
 void JetErrorAnalysis::processRunHeader()
@@ -358,308 +601,404 @@ void JetErrorAnalysis::processRunHeader()
 
 void JetErrorAnalysis::processEvent( LCEvent* pLCEvent)
 {
-	LCCollection *recoJetCol{};
-	LCCollection *trueJetCol{};
-	LCCollection *refJetCol{};
-	m_nRun = pLCEvent->getRunNumber();
-	m_nEvt = pLCEvent->getEventNumber();
-	this->Clear();
-	std::string trueJetType[6]{ "hadronic (string)" , "leptonic" , "hadronic(cluster)" , "ISR" , "overlay" , "M.E. photon" };
-	std::string icnType[6]{ "quark pair" , "lepton pair" , "quark pair" , "ISR" , "???" , "M.E. photon" };
-	streamlog_out(MESSAGE) << "" << std::endl;
-	streamlog_out(MESSAGE) << "	////////////////////////////////////////////////////////////////////////////" << std::endl;
-	streamlog_out(MESSAGE) << "	////////////////////	Processing event: 	" << m_nEvt << "	////////////////////" << std::endl;
-	streamlog_out(MESSAGE) << "	////////////////////////////////////////////////////////////////////////////" << std::endl;
-
-	try
-	{
-		recoJetCol		= pLCEvent->getCollection( m_recoJetCollectionName );
-		trueJetCol		= pLCEvent->getCollection( _trueJetCollectionName );
-		refJetCol		= pLCEvent->getCollection( m_referenceJetCollection );
-		TrueJet_Parser* trueJet	= this;
-		trueJet->getall(pLCEvent);
-
-		m_nRecoJets = recoJetCol->getNumberOfElements();
-		streamlog_out(DEBUG3) << "	Number of Reconstructed Jets: " << m_nRecoJets << std::endl;
-
-		int njets = trueJet->njets();
-		streamlog_out(DEBUG3) << "	Number of True Jets: " << njets << std::endl;
-		std::vector<int> trueHadronicJetIndices; trueHadronicJetIndices.clear();
-		std::vector<int> recoJetIndices; recoJetIndices.clear();
-		for (int i_jet = 0 ; i_jet < njets ; i_jet++ )
+	processEventConcurrent( pLCEvent , 0 , m_nReadEvents++ );
+}
+
+void JetErrorAnalysis::processEventConcurrent( LCEvent* pLCEvent , int slot , long long sequence )
+{
+	WorkerSlot &workerSlot = *m_workerSlots.at( slot );
+	ProcessorStatistics &statistics = workerSlot.eventContext.statistics();
+	ScopedStageTimer eventTimer( statistics , ProcessorStatistics::kProcessEvent );
+	EventResult &result = workerSlot.result;
+	result.clear();
+	workerSlot.resultCapacity.reserve( result );
+	result.speciesTrackEnergyTotal.assign( m_trackSpecies.size() , 0.0 );
+	result.run = pLCEvent->getRunNumber();
+	result.event = pLCEvent->getEventNumber();
+	statistics.count( ProcessorStatistics::kEvents );
+	if ( logEvery( sequence , m_eventSummaryInterval ) )
+	{
+		jea_event_out( m_eventLogging , MESSAGE ) << "" << std::endl;
+		jea_event_out( m_eventLogging , MESSAGE ) << "	////////////////////////////////////////////////////////////////////////////" << std::endl;
+		jea_event_out( m_eventLogging , MESSAGE ) << "	////////////////////	Processing event: 	" << result.event << "	////////////////////" << std::endl;
+		jea_event_out( m_eventLogging , MESSAGE ) << "	////////////////////////////////////////////////////////////////////////////" << std::endl;
+	}
+
+	workerSlot.eventContext.resolve( pLCEvent );
+	if ( !workerSlot.eventContext.hasJetInput() )
+	{
+		jea_event_out( m_eventLogging , MESSAGE ) << "	Check : Input collections not found in event " << result.event << " ( " << workerSlot.eventContext.missingCollections() << " )" << std::endl;
+		statistics.count( ProcessorStatistics::kEventsSkippedMissingInput );
+	}
+	else
+	{
+		try
 		{
-			m_trueJetType.push_back( type_jet( i_jet ) );
-			streamlog_out(DEBUG0) << "	Type of True Jet[ " << i_jet << " ]: " << type_jet( i_jet ) << " ( " << trueJetType[ abs( type_jet( i_jet ) ) ] << " ) ; 	PDG of Initial Colour Neutral = " << pdg_icn_parent( initial_cn( i_jet ) ) << " ; 	Type of Final Colour Neutral : " << type_icn_parent( initial_cn( i_jet ) ) << "( " << icnType[ type_icn_parent( initial_cn( i_jet ) ) ] << " )" << std::endl;
-			if ( type_jet( i_jet ) == 1 )
+			bool rejected = false;
+			if ( m_lazyTrueJetParsing && skipTrueJetParsing( workerSlot.eventContext , result ) )
 			{
-				++m_nTrueJets;
-				trueHadronicJetIndices.push_back( i_jet );
+				statistics.count( ProcessorStatistics::kEventsRejectedJetMultiplicity );
+				rejected = true;
 			}
-		}
-		streamlog_out(DEBUG3) << "	Number of True Hadronic Jets(type = 1): " << m_nTrueJets << std::endl;
-		double KaonTrackEnergyinJet;
-		double ProtonTrackEnergyinJet;
-		if ( m_nRecoJets == m_nTrueJets )
-		{
-			for ( int i_trueJet = 0 ; i_trueJet < m_nTrueJets ; ++i_trueJet )
+			else if ( m_skipFillOnReject && !hasPIDTrackEnergy( workerSlot.eventContext ) )
 			{
-				TVector3 trueJetMomentum( ptrueseen( trueHadronicJetIndices[ i_trueJet ] )[ 0 ] , ptrueseen( trueHadronicJetIndices[ i_trueJet ] )[ 1 ] , ptrueseen( trueHadronicJetIndices[ i_trueJet ] )[ 2 ] );
-				streamlog_out(DEBUG2) << "	True(seen) Jet Momentum[ " << trueHadronicJetIndices[ i_trueJet ] << " ]: (	" << ptrueseen( trueHadronicJetIndices[ i_trueJet ] )[ 0 ] << " 	, " << ptrueseen( trueHadronicJetIndices[ i_trueJet ] )[ 1 ] << " 	, " << ptrueseen( trueHadronicJetIndices[ i_trueJet ] )[ 2 ] << "	)" << std::endl;
-				TVector3 trueJetMomentumUnit = trueJetMomentum; trueJetMomentumUnit.SetMag(1.0);
-				float CosWidestAngle = -1.0;
-				int matchedRecoJetIndex = -1;
-				for ( int i_recoJet = 0 ; i_recoJet < m_nRecoJets ; ++i_recoJet )
-				{
-					ReconstructedParticle *recoJet = dynamic_cast<ReconstructedParticle*>( recoJetCol->getElementAt( i_recoJet ) );
-					TVector3 recoJetMometnum( recoJet->getMomentum() );
-					TVector3 recoJetMometnumUnit = recoJetMometnum; recoJetMometnumUnit.SetMag(1.0);
-					streamlog_out(DEBUG2) << "	Reco Jet Momentum[ " << i_recoJet << " ]: (	" << recoJet->getMomentum()[ 0 ] << " 	, " << recoJet->getMomentum()[ 1 ] << " 	, " << recoJet->getMomentum()[ 2 ] << "	)" << std::endl;
-					if ( trueJetMomentumUnit.Dot( recoJetMometnumUnit ) >= CosWidestAngle )
-					{
-						CosWidestAngle = trueJetMomentumUnit.Dot( recoJetMometnumUnit );
-						matchedRecoJetIndex = i_recoJet;
-					}
-				}
-				streamlog_out(DEBUG2) << "	True(seen) Jet [ " << trueHadronicJetIndices[ i_trueJet ] << " ] is matched with RecoJet [ " << matchedRecoJetIndex << " ]" << std::endl;
-				recoJetIndices.push_back( matchedRecoJetIndex );
+				statistics.count( ProcessorStatistics::kEventsRejectedPIDTracks );
+				rejected = true;
 			}
-			for ( int i_jet = 0 ; i_jet < m_nTrueJets ; ++i_jet )
+
+			// a rejected event that is written still gets its flavour history, one that is not skips the MCParticle pass
+			if ( !( rejected && m_skipFillOnReject ) )
+			{
+				ScopedStageTimer ancestryTimer( statistics , ProcessorStatistics::kMCParticleLoop );
+				fillFlavourHistory( workerSlot.eventContext , result );
+			}
+			if ( !rejected )
 			{
-				bool trueJetCriteria = false;
-				bool recoJetCriteria = false;
-				KaonTrackEnergyinJet = 0.0;
-				ProtonTrackEnergyinJet = 0.0;
-				const EVENT::MCParticleVec& mcpVec =  true_partics( trueHadronicJetIndices[ i_jet ] );
-				streamlog_out(DEBUG3) << "	Number of all MCParticles in trueJet [ " << trueHadronicJetIndices[ i_jet ] << " ] : " << mcpVec.size() << std::endl;
-				for ( unsigned int i_mcp = 0 ; i_mcp < mcpVec.size() ; ++i_mcp )
-				{
-					EVENT::MCParticle *testMCP = mcpVec.at( i_mcp );
-					streamlog_out(DEBUG1) << "	MCParticle [ " << i_mcp << " ] : 	GeneratorStatus = " << testMCP->getGeneratorStatus() << " ; 	PDGCode = " << testMCP->getPDG() << std::endl;
-					if ( testMCP->getGeneratorStatus() == 1 && abs( testMCP->getPDG() ) == 321 )
-					{
-						m_trueKaonEnergy.push_back( testMCP->getEnergy() );
-						m_trueKaonEnergyTotal += testMCP->getEnergy();
-					}
-					else if ( testMCP->getGeneratorStatus() == 1 && abs( testMCP->getPDG() ) == 2212 )
-					{
-						m_trueProtonEnergy.push_back( testMCP->getEnergy() );
-						m_trueProtonEnergyTotal += testMCP->getEnergy();
-					}
-				}
-				ReconstructedParticle *recoJet = dynamic_cast<ReconstructedParticle*>( recoJetCol->getElementAt( recoJetIndices[ i_jet ] ) );
-				ReconstructedParticle *refJet = dynamic_cast<ReconstructedParticle*>( refJetCol->getElementAt( recoJetIndices[ i_jet ] ) );
-				ReconstructedParticleVec jetRecoPFOs  = recoJet->getParticles();
-				ReconstructedParticleVec refjetRecoPFOs  = refJet->getParticles();
-				streamlog_out(DEBUG3) << "	Number of all Reconstructed Particles in recoJet [ " << recoJetIndices[ i_jet ] << " ] : " << jetRecoPFOs.size() << std::endl;
-				streamlog_out(DEBUG3) << "	Number of all Reconstructed Particles in refJet [ " << recoJetIndices[ i_jet ] << " ] : " << refjetRecoPFOs.size() << std::endl;
-				if ( jetRecoPFOs.size() != refjetRecoPFOs.size() ) continue;
-				for ( unsigned int i_pfo = 0 ; i_pfo < jetRecoPFOs.size() ; ++i_pfo )
 				{
-					EVENT::ReconstructedParticle *testPFO = jetRecoPFOs.at( i_pfo );
-					EVENT::ReconstructedParticle *refPFO = refjetRecoPFOs.at( i_pfo );
-					streamlog_out(DEBUG1) << "	PFO [ " << i_pfo << " ] : 	PFO Type = " << testPFO->getType() << std::endl;
-					getTrackInformation( pLCEvent , refPFO , KaonTrackEnergyinJet , ProtonTrackEnergyinJet );
+					ScopedStageTimer trueJetTimer( statistics , ProcessorStatistics::kTrueJetParsing );
+					workerSlot.trueJet->getall( pLCEvent );
 				}
-				TLorentzVector trueJetFourMomentum( p4trueseen( trueHadronicJetIndices[ i_jet ] )[ 1 ] , p4trueseen( trueHadronicJetIndices[ i_jet ] )[ 2 ] , p4trueseen( trueHadronicJetIndices[ i_jet ] )[ 3 ] , p4trueseen( trueHadronicJetIndices[ i_jet ] )[ 0 ] );
-				m_KaonTrackEnergyinJet.push_back( KaonTrackEnergyinJet );
-				m_ProtonTrackEnergyinJet.push_back( ProtonTrackEnergyinJet );
-				if ( KaonTrackEnergyinJet >= m_minKaonTrackEnergy && ProtonTrackEnergyinJet >= m_minProtonTrackEnergy ) getJetResiduals( trueJetFourMomentum , recoJet );
+				analyseEvent( workerSlot.eventContext , *workerSlot.trueJet , result );
 			}
-
+			workerSlot.resultCapacity.update( result );
+			result.accepted = !( rejected && m_skipFillOnReject );
+		}
+		catch(DataNotAvailableException &e)
+		{
+			jea_event_out( m_eventLogging , MESSAGE ) << "	Check : Input collections not found in event " << result.event << std::endl;
+			result.accepted = false;
+			statistics.count( ProcessorStatistics::kEventsSkippedDataNotAvailable );
 		}
-		m_nEvtSum++;
-		m_nEvt++ ;
-		m_pTTree->Fill();
 	}
-	catch(DataNotAvailableException &e)
+	commitEventResult( sequence , result );
+}
+
+bool JetErrorAnalysis::skipTrueJetParsing( const EventContext &eventContext , EventResult &result ) const
+{
+	// TrueJet_Parser::type_jet is the type of the first ParticleID of the jet in the TrueJets collection
+	LCCollection *trueJetCol = eventContext.collection( EventContext::kTrueJets );
+	const int nRecoJets = eventContext.collection( EventContext::kRecoJets )->getNumberOfElements();
+	const int njets = trueJetCol->getNumberOfElements();
+	int nTrueHadronicJets = 0;
+	for ( int i_jet = 0 ; i_jet < njets ; ++i_jet )
 	{
-		streamlog_out(MESSAGE) << "	Check : Input collections not found in event " << m_nEvt << std::endl;
+		const ReconstructedParticle *trueJet = dynamic_cast<const ReconstructedParticle*>( trueJetCol->getElementAt( i_jet ) );
+		if ( trueJet->getParticleIDs().empty() ) return false;
+		if ( trueJet->getParticleIDs()[ 0 ]->getType() == 1 ) ++nTrueHadronicJets;
 	}
+	if ( nTrueHadronicJets > 0 && nTrueHadronicJets == nRecoJets ) return false;
 
-
+	// what analyseEvent writes for an event without matched jets
+	result.nRecoJets = nRecoJets;
+	result.nTrueJets = nTrueHadronicJets;
+	for ( int i_jet = 0 ; i_jet < njets ; ++i_jet )
+	{
+		result.trueJetType.push_back( dynamic_cast<const ReconstructedParticle*>( trueJetCol->getElementAt( i_jet ) )->getParticleIDs()[ 0 ]->getType() );
+	}
+	jea_event_debug_out( m_eventLogging , DEBUG3 ) << "	" << nTrueHadronicJets << " true hadronic jets and " << nRecoJets << " reconstructed jets, TrueJet not parsed" << std::endl;
+	return true;
 }
 
-void JetErrorAnalysis::getJetResiduals( TLorentzVector trueJetFourMomentum , EVENT::ReconstructedParticle *recoJet )
+void JetErrorAnalysis::fillFlavourHistory( EventContext &eventContext , EventResult &result ) const
 {
-	double trueJetPx = trueJetFourMomentum.Px();
-	double trueJetPy = trueJetFourMomentum.Py();
-	double trueJetPz = trueJetFourMomentum.Pz();
-	double trueJetE = trueJetFourMomentum.E();
-	double trueJetTheta = trueJetFourMomentum.Theta();
-	double trueJetPhi = trueJetFourMomentum.Phi();
-	TVector3 trueP( trueJetPx , trueJetPy , trueJetPz );
-	TVector3 truePunit = trueP; truePunit.SetMag(1.0);
-	TVector3 truePt( trueJetPx , trueJetPy , 0.0 );
-	TVector3 truePtunit = truePt; truePtunit.SetMag(1.0);
-	TLorentzVector recoJetFourMomentum( recoJet->getMomentum()[ 0 ] , recoJet->getMomentum()[ 1 ] , recoJet->getMomentum()[ 2 ] , recoJet->getEnergy() );
-	double recoJetPx = recoJetFourMomentum.Px();
-	double recoJetPy = recoJetFourMomentum.Py();
-	double recoJetPz = recoJetFourMomentum.Pz();
-	double recoJetPt = std::sqrt( pow( recoJetPx , 2 ) + pow( recoJetPy , 2 ) );
-	double recoJetPt2 = pow( recoJetPx , 2 ) + pow( recoJetPy , 2 );
-	double recoJetP2 = pow( recoJetPx , 2 ) + pow( recoJetPy , 2 ) + pow( recoJetPz , 2 );
-	double recoJetE = recoJetFourMomentum.E();
-	double recoJetTheta = recoJetFourMomentum.Theta();
-	double recoJetPhi = recoJetFourMomentum.Phi();
-	TVector3 recoP( recoJetPx , recoJetPy , recoJetPz );
-	TVector3 recoPunit = recoP; recoPunit.SetMag(1.0);
-	TVector3 recoProtated = recoP; recoProtated.SetMag(1.0); recoProtated.SetPhi( trueJetPhi );
-	TVector3 recoPt( recoJetPx , recoJetPy , 0.0 );
-	TVector3 recoPtunit = recoPt; recoPtunit.SetMag(1.0);
-	double sigmaPx2 = recoJet->getCovMatrix()[ 0 ];
-	double sigmaPxPy = recoJet->getCovMatrix()[ 1 ];
-	double sigmaPy2 = recoJet->getCovMatrix()[ 2 ];
-	double sigmaPxPz = recoJet->getCovMatrix()[ 3 ];
-	double sigmaPyPz = recoJet->getCovMatrix()[ 4 ];
-	double sigmaPz2 = recoJet->getCovMatrix()[ 5 ];
-	double sigmaPxE = recoJet->getCovMatrix()[ 6 ];
-	double sigmaPyE = recoJet->getCovMatrix()[ 7 ];
-	double sigmaPzE = recoJet->getCovMatrix()[ 8 ];
-	double sigmaE2 = recoJet->getCovMatrix()[ 9 ];
-	double dTheta_dPx = recoJetPx * recoJetPz / ( recoJetP2 * recoJetPt );
-	double dTheta_dPy = recoJetPy * recoJetPz / ( recoJetP2 * recoJetPt );
-	double dTheta_dPz = -recoJetPt / recoJetP2;
-	double dPhi_dPx = -recoJetPy / recoJetPt2;
-	double dPhi_dPy = recoJetPx / recoJetPt2;
-	double sigmaTheta = std::sqrt( std::fabs( sigmaPx2 * std::pow( dTheta_dPx , 2 ) + sigmaPy2 * std::pow( dTheta_dPy , 2 ) + sigmaPz2 * std::pow( dTheta_dPz , 2 ) + 2 * ( sigmaPxPy * dTheta_dPx * dTheta_dPy ) + 2 * ( sigmaPxPz * dTheta_dPx * dTheta_dPz ) + 2 * ( sigmaPyPz * dTheta_dPy * dTheta_dPz ) ) );
-	double sigmaPhi = std::sqrt( std::fabs( sigmaPx2 * std::pow( dPhi_dPx , 2 ) + sigmaPy2 * std::pow( dPhi_dPy , 2 ) + 2 * ( sigmaPxPy * dPhi_dPx * dPhi_dPy ) ) );
-	m_ResidualPx.push_back( recoJetPx - trueJetPx );
-	h_ResidualPx->Fill( recoJetPx - trueJetPx ); ++n_ResidualPx;
-	m_ResidualPy.push_back( recoJetPy - trueJetPy );
-	h_ResidualPy->Fill( recoJetPy - trueJetPy ); ++n_ResidualPy;
-	m_ResidualPz.push_back( recoJetPz - trueJetPz );
-	h_ResidualPz->Fill( recoJetPz - trueJetPz ); ++n_ResidualPz;
-	m_ResidualE.push_back( recoJetE - trueJetE );
-	h_ResidualE->Fill( recoJetE - trueJetE ); ++n_ResidualE;
-	m_NormalizedResidualPx.push_back( ( recoJetPx - trueJetPx ) / std::sqrt( sigmaPx2 ) );
-	h_NormalizedResidualPx->Fill( ( recoJetPx - trueJetPx ) / std::sqrt( sigmaPx2 ) ); ++n_NormalizedResidualPx;
-	m_NormalizedResidualPy.push_back( ( recoJetPy - trueJetPy ) / std::sqrt( sigmaPy2 ) );
-	h_NormalizedResidualPy->Fill( ( recoJetPy - trueJetPy ) / std::sqrt( sigmaPy2 ) ); ++n_NormalizedResidualPy;
-	m_NormalizedResidualPz.push_back( ( recoJetPz - trueJetPz ) / std::sqrt( sigmaPz2 ) );
-	h_NormalizedResidualPz->Fill( ( recoJetPz - trueJetPz ) / std::sqrt( sigmaPz2 ) ); ++n_NormalizedResidualPz;
-	m_NormalizedResidualE.push_back( ( recoJetE - trueJetE ) / std::sqrt( sigmaE2 ) );
-	h_NormalizedResidualE->Fill( ( recoJetE - trueJetE ) / std::sqrt( sigmaE2 ) ); ++n_NormalizedResidualE;
-	double ThetaResidual = ( ( recoJetTheta - trueJetTheta ) > 0 ? acos( truePunit.Dot(recoProtated) ) : -1 * acos( truePunit.Dot(recoProtated) ) );
-	m_ResidualTheta.push_back( ThetaResidual );
-	h_ResidualTheta->Fill( ThetaResidual ); ++n_ResidualTheta;
-	m_NormalizedResidualTheta.push_back( ThetaResidual / sigmaTheta );
-	h_NormalizedResidualTheta->Fill( ThetaResidual / sigmaTheta ); ++n_NormalizedResidualTheta;
-	double PhiResidual = ( ( recoJetPhi - trueJetPhi ) > 0 ? acos( truePtunit.Dot(recoPtunit) ) : -1 * acos( truePtunit.Dot(recoPtunit) ) );
-	m_ResidualPhi.push_back( PhiResidual );
-	h_ResidualPhi->Fill( PhiResidual ); ++n_ResidualPhi;
-	m_NormalizedResidualPhi.push_back( PhiResidual / sigmaPhi );
-	h_NormalizedResidualPhi->Fill( PhiResidual / sigmaPhi ); ++n_NormalizedResidualPhi;
+	eventContext.indexMCParticles();
+	const MCParticleAncestry &mcParticleAncestry = eventContext.mcParticleAncestry();
+	result.nSLDecayBHadron = mcParticleAncestry.nSemileptonicDecays( MCParticleAncestry::kBottom );
+	result.nSLDecayCHadron = mcParticleAncestry.nSemileptonicDecays( MCParticleAncestry::kCharm );
+	result.nSLDecayTotal = result.nSLDecayBHadron + result.nSLDecayCHadron;
+
+	// TrueJet_Parser::true_partics( i_jet ) are the MCParticles linked from the i_jet-th element of TrueJets
+	LCCollection *trueJetCol = eventContext.collection( EventContext::kTrueJets );
+	LCCollection *trueJetMCParticleLinkCol = eventContext.collection( EventContext::kTrueJetMCParticleLink );
+	eventContext.indexTrueJets();
+	const PointerIndex<LCObject> &trueJetIndex = eventContext.trueJetIndex();
+	result.trueJetFlavour.assign( trueJetCol->getNumberOfElements() , MCParticleAncestry::kLight );
+	for ( int i_rel = 0 ; i_rel < trueJetMCParticleLinkCol->getNumberOfElements() ; ++i_rel )
+	{
+		const LCRelation *relation = dynamic_cast<const LCRelation*>( trueJetMCParticleLinkCol->getElementAt( i_rel ) );
+		const MCParticle *mcParticle = dynamic_cast<const MCParticle*>( relation->getTo() );
+		const int i_jet = trueJetIndex.find( relation->getFrom() );
+		if ( i_jet == -1 || mcParticle == NULL ) continue;
+		result.trueJetFlavour[ i_jet ] = std::max( result.trueJetFlavour[ i_jet ] , mcParticleAncestry.heaviestFlavour( mcParticle ) );
+	}
 }
 
-
-void JetErrorAnalysis::getTrackInformation( LCEvent* pLCEvent , EVENT::ReconstructedParticle *testPFO , double &KaonTrackEnergyinJet , double &ProtonTrackEnergyinJet )
+bool JetErrorAnalysis::hasPIDTrackEnergy( EventContext &eventContext ) const
 {
-	LCCollection *MarlinTrkTracks{};
-	LCCollection *MarlinTrkTracksKAON{};
-	LCCollection *MarlinTrkTracksPROTON{};
-	try
-	{
-		MarlinTrkTracks = pLCEvent->getCollection(m_MarlinTrkTracks);
-		MarlinTrkTracksKAON = pLCEvent->getCollection(m_MarlinTrkTracksKAON);
-		MarlinTrkTracksPROTON = pLCEvent->getCollection(m_MarlinTrkTracksPROTON);
-	}
-	catch (DataNotAvailableException &e)
+	// the kaon ( proton ) track energy of a jet is at most that of all tracks in the kaon ( proton ) collections;
+	// the sums go through the TrackMomentumBatch of the jets, chunk by chunk so that the loop stops as soon as one
+	// configuration is reached, and are compared with a margin for the different order of the additions
+	TrackClassifier &trackClassifier = eventContext.trackClassifier();
+	double trackEnergy[ TrackSpeciesOutput::kNJetEnergies ]{};
+	if ( acceptsJet( 0.0 , 0.0 ) ) return true;
+	for ( int i_species = 1 ; i_species < trackClassifier.nSpecies() ; ++i_species )
 	{
-		streamlog_out(WARNING) << "	Could not find one of  " << MarlinTrkTracks << " / " << MarlinTrkTracksKAON << " / " << MarlinTrkTracksPROTON << " Collection" << std::endl;
+		const int jetEnergy = m_trackSpeciesOutputs[ i_species ].jetEnergy;
+		LCCollection *trackCol = trackClassifier.collection( i_species );
+		if ( jetEnergy == TrackSpeciesOutput::kNoJetEnergy || trackCol == NULL ) continue;
+		const int nTRKs = trackCol->getNumberOfElements();
+		for ( int first = 0 ; first < nTRKs ; first += kPIDTrackChunk )
+		{
+			trackClassifier.clearTracks();
+			trackClassifier.addCollectionTracks( i_species , first , std::min( kPIDTrackChunk , nTRKs - first ) );
+			trackClassifier.computeEnergies();
+			trackEnergy[ jetEnergy ] += trackClassifier.speciesEnergy( i_species );
+			if ( acceptsJet( trackEnergy[ TrackSpeciesOutput::kKaonJetEnergy ] * kPIDTrackEnergyMargin , trackEnergy[ TrackSpeciesOutput::kProtonJetEnergy ] * kPIDTrackEnergyMargin ) ) return true;
+		}
 	}
-	const EVENT::TrackVec& inputPFOtrkvec = testPFO->getTracks();
-	int nTRKsofPFO = inputPFOtrkvec.size();
-	TLorentzVector pfoFourMomentum( 0.0 , 0.0 , 0.0 , 0.0 );
-	for ( int i_trk = 0 ; i_trk < nTRKsofPFO ; ++i_trk )
-	{
-		Track *pfoTrk = (Track*)inputPFOtrkvec.at( i_trk );
-		float trackMass = 0.0;
-		TLorentzVector trackFourMomentum( 0.0 , 0.0 , 0.0 , 0.0 );
-		if ( getTrackIndex( MarlinTrkTracksPROTON , pfoTrk ) != -1 )
+	return false;
+}
+
+void JetErrorAnalysis::analyseEvent( EventContext &eventContext , TrueJet_Parser &trueJet , EventResult &result ) const
+{
+	static const char *trueJetType[6]{ "hadronic (string)" , "leptonic" , "hadronic(cluster)" , "ISR" , "overlay" , "M.E. photon" };
+	static const char *icnType[6]{ "quark pair" , "lepton pair" , "quark pair" , "ISR" , "???" , "M.E. photon" };
+	LCCollection *recoJetCol = eventContext.collection( EventContext::kRecoJets );
+	LCCollection *refJetCol = eventContext.collection( EventContext::kReferenceJets );
+	ProcessorStatistics &statistics = eventContext.statistics();
+
+	result.nRecoJets = recoJetCol->getNumberOfElements();
+	jea_event_out( m_eventLogging , DEBUG3 ) << "	Number of Reconstructed Jets: " << result.nRecoJets << std::endl;
+
+	int njets = trueJet.njets();
+	jea_event_out( m_eventLogging , DEBUG3 ) << "	Number of True Jets: " << njets << std::endl;
+	std::vector<int> &trueHadronicJetIndices = eventContext.trueHadronicJetIndices();
+	trueHadronicJetIndices.clear();
+	for (int i_jet = 0 ; i_jet < njets ; i_jet++ )
+	{
+		result.trueJetType.push_back( trueJet.type_jet( i_jet ) );
+		jea_event_debug_out( m_eventLogging , DEBUG0 ) << "	Type of True Jet[ " << i_jet << " ]: " << trueJet.type_jet( i_jet ) << " ( " << trueJetType[ abs( trueJet.type_jet( i_jet ) ) ] << " ) ; 	PDG of Initial Colour Neutral = " << trueJet.pdg_icn_parent( trueJet.initial_cn( i_jet ) ) << " ; 	Type of Final Colour Neutral : " << trueJet.type_icn_parent( trueJet.initial_cn( i_jet ) ) << "( " << icnType[ trueJet.type_icn_parent( trueJet.initial_cn( i_jet ) ) ] << " )" << std::endl;
+		if ( trueJet.type_jet( i_jet ) == 1 )
 		{
-			trackMass = m_proton_mass;
+			++result.nTrueJets;
+			trueHadronicJetIndices.push_back( i_jet );
 		}
-		else if ( getTrackIndex( MarlinTrkTracksKAON , pfoTrk ) != -1 )
+	}
+	jea_event_out( m_eventLogging , DEBUG3 ) << "	Number of True Hadronic Jets(type = 1): " << result.nTrueJets << std::endl;
+	double KaonTrackEnergyinJet;
+	double ProtonTrackEnergyinJet;
+	if ( result.nRecoJets == result.nTrueJets )
+	{
+		eventContext.indexTracks();
+		JetResidualBatch &residualBatch = eventContext.residualBatch();
+		residualBatch.clear();
+		JetMatcher &jetMatcher = eventContext.jetMatcher();
+		jetMatcher.clear();
+		ScopedStageTimer matchingTimer( statistics , ProcessorStatistics::kJetMatching );
+		for ( int i_trueJet = 0 ; i_trueJet < result.nTrueJets ; ++i_trueJet )
 		{
-			trackMass = m_kaon_mass;
+			const double *trueJetMomentum = trueJet.ptrueseen( trueHadronicJetIndices[ i_trueJet ] );
+			jea_event_debug_out( m_eventLogging , DEBUG2 ) << "	True(seen) Jet Momentum[ " << trueHadronicJetIndices[ i_trueJet ] << " ]: (	" << trueJetMomentum[ 0 ] << " 	, " << trueJetMomentum[ 1 ] << " 	, " << trueJetMomentum[ 2 ] << "	)" << std::endl;
+			jetMatcher.addTrueJet( trueJetMomentum );
 		}
-		else
+		for ( int i_recoJet = 0 ; i_recoJet < result.nRecoJets ; ++i_recoJet )
 		{
-			trackMass = m_pion_mass;
-		}//( getTrackIndex( MarlinTrkTracks , pfoTrk ) != -1  )
-		trackFourMomentum = getTrackFourMomentum( pfoTrk , trackMass );
-		if ( trackMass == m_proton_mass )
+			ReconstructedParticle *recoJet = dynamic_cast<ReconstructedParticle*>( recoJetCol->getElementAt( i_recoJet ) );
+			jea_event_debug_out( m_eventLogging , DEBUG2 ) << "	Reco Jet Momentum[ " << i_recoJet << " ]: (	" << recoJet->getMomentum()[ 0 ] << " 	, " << recoJet->getMomentum()[ 1 ] << " 	, " << recoJet->getMomentum()[ 2 ] << "	)" << std::endl;
+			jetMatcher.addRecoJet( recoJet->getMomentum() );
+		}
+		const std::vector<int> &recoJetIndices = jetMatcher.match();
+		matchingTimer.stop();
+		for ( int i_trueJet = 0 ; i_trueJet < result.nTrueJets ; ++i_trueJet )
 		{
-			m_protonTrackEnergy.push_back( trackFourMomentum.E() );
-			m_protonTrackEnergyTotal += trackFourMomentum.E();
-			ProtonTrackEnergyinJet += trackFourMomentum.E();
+			jea_event_debug_out( m_eventLogging , DEBUG2 ) << "	True(seen) Jet [ " << trueHadronicJetIndices[ i_trueJet ] << " ] is matched with RecoJet [ " << recoJetIndices[ i_trueJet ] << " ]" << std::endl;
 		}
-		else if ( trackMass == m_kaon_mass )
+		for ( int i_jet = 0 ; i_jet < result.nTrueJets ; ++i_jet )
 		{
-			m_kaonTrackEnergy.push_back( trackFourMomentum.E() );
-			m_kaonTrackEnergyTotal += trackFourMomentum.E();
-			KaonTrackEnergyinJet += trackFourMomentum.E();
+			KaonTrackEnergyinJet = 0.0;
+			ProtonTrackEnergyinJet = 0.0;
+			const EVENT::MCParticleVec& mcpVec =  trueJet.true_partics( trueHadronicJetIndices[ i_jet ] );
+			jea_event_out( m_eventLogging , DEBUG3 ) << "	Number of all MCParticles in trueJet [ " << trueHadronicJetIndices[ i_jet ] << " ] : " << mcpVec.size() << std::endl;
+			ScopedStageTimer mcParticleTimer( statistics , ProcessorStatistics::kMCParticleLoop );
+			for ( unsigned int i_mcp = 0 ; i_mcp < mcpVec.size() ; ++i_mcp )
+			{
+				EVENT::MCParticle *testMCP = mcpVec.at( i_mcp );
+				jea_event_debug_out( m_eventLogging , DEBUG1 ) << "	MCParticle [ " << i_mcp << " ] : 	GeneratorStatus = " << testMCP->getGeneratorStatus() << " ; 	PDGCode = " << testMCP->getPDG() << std::endl;
+				if ( testMCP->getGeneratorStatus() == 1 && abs( testMCP->getPDG() ) == 321 )
+				{
+					result.trueKaonEnergy.push_back( testMCP->getEnergy() );
+					result.trueKaonEnergyTotal += testMCP->getEnergy();
+				}
+				else if ( testMCP->getGeneratorStatus() == 1 && abs( testMCP->getPDG() ) == 2212 )
+				{
+					result.trueProtonEnergy.push_back( testMCP->getEnergy() );
+					result.trueProtonEnergyTotal += testMCP->getEnergy();
+				}
+			}
+			mcParticleTimer.stop();
+			ReconstructedParticle *recoJet = dynamic_cast<ReconstructedParticle*>( recoJetCol->getElementAt( recoJetIndices[ i_jet ] ) );
+			ReconstructedParticle *refJet = dynamic_cast<ReconstructedParticle*>( refJetCol->getElementAt( recoJetIndices[ i_jet ] ) );
+			const ReconstructedParticleVec &jetRecoPFOs = recoJet->getParticles();
+			const ReconstructedParticleVec &refjetRecoPFOs = refJet->getParticles();
+			jea_event_out( m_eventLogging , DEBUG3 ) << "	Number of all Reconstructed Particles in recoJet [ " << recoJetIndices[ i_jet ] << " ] : " << jetRecoPFOs.size() << std::endl;
+			jea_event_out( m_eventLogging , DEBUG3 ) << "	Number of all Reconstructed Particles in refJet [ " << recoJetIndices[ i_jet ] << " ] : " << refjetRecoPFOs.size() << std::endl;
+			const double *trueJetP4 = trueJet.p4trueseen( trueHadronicJetIndices[ i_jet ] );
+			EventResult::JetRecord jetRecord{};
+			jetRecord.trueJetIndex = trueHadronicJetIndices[ i_jet ];
+			jetRecord.recoJetIndex = recoJetIndices[ i_jet ];
+			jetRecord.trueJetFlavour = result.trueJetFlavour[ trueHadronicJetIndices[ i_jet ] ];
+			jetRecord.nPFOs = jetRecoPFOs.size();
+			jetRecord.trueE = trueJetP4[ 0 ];
+			jetRecord.truePx = trueJetP4[ 1 ];
+			jetRecord.truePy = trueJetP4[ 2 ];
+			jetRecord.truePz = trueJetP4[ 3 ];
+			jetRecord.recoE = recoJet->getEnergy();
+			jetRecord.recoPx = recoJet->getMomentum()[ 0 ];
+			jetRecord.recoPy = recoJet->getMomentum()[ 1 ];
+			jetRecord.recoPz = recoJet->getMomentum()[ 2 ];
+			if ( jetRecoPFOs.size() != refjetRecoPFOs.size() )
+			{
+				statistics.count( ProcessorStatistics::kJetsSkippedPFOMismatch );
+				result.jetRecords.push_back( jetRecord );
+				continue;
+			}
+			jetRecord.pfoListsMatch = 1;
+			ScopedStageTimer trackTimer( statistics , ProcessorStatistics::kTrackClassification );
+			TrackClassifier &trackClassifier = eventContext.trackClassifier();
+			trackClassifier.clearTracks();
+			JetCovarianceBuilder &jetCovarianceBuilder = eventContext.jetCovarianceBuilder();
+			jetCovarianceBuilder.clear();
+			for ( unsigned int i_pfo = 0 ; i_pfo < jetRecoPFOs.size() ; ++i_pfo )
+			{
+				const EVENT::ReconstructedParticle *testPFO = jetRecoPFOs[ i_pfo ];
+				const EVENT::ReconstructedParticle *refPFO = refjetRecoPFOs[ i_pfo ];
+				jea_event_debug_out( m_eventLogging , DEBUG1 ) << "	PFO [ " << i_pfo << " ] : 	PFO Type = " << testPFO->getType() << std::endl;
+				trackClassifier.addTracks( refPFO->getTracks() );
+				if ( m_rebuildJetCovariance ) jetCovarianceBuilder.addParticle( refPFO );
+			}
+			trackClassifier.computeEnergies();
+			if ( m_rebuildJetCovariance )
+			{
+				// jetTree holds the reconstructed four-momentum the residuals are computed from
+				jetCovarianceBuilder.finish( trackClassifier.momenta() );
+				jetRecord.recoPx = jetCovarianceBuilder.fourMomentum()[ 0 ];
+				jetRecord.recoPy = jetCovarianceBuilder.fourMomentum()[ 1 ];
+				jetRecord.recoPz = jetCovarianceBuilder.fourMomentum()[ 2 ];
+				jetRecord.recoE = jetCovarianceBuilder.fourMomentum()[ 3 ];
+			}
+			fillTrackEnergies( trackClassifier , KaonTrackEnergyinJet , ProtonTrackEnergyinJet , result );
+			trackTimer.stop();
+			// a track found in none of the species collections is taken as species 0
+			statistics.count( ProcessorStatistics::kPFOsVisited , jetRecoPFOs.size() );
+			statistics.count( ProcessorStatistics::kTracksClassified , trackClassifier.nTracks() );
+			statistics.count( ProcessorStatistics::kTracksDefaultSpecies , trackClassifier.speciesTracks( 0 ) );
+			result.kaonTrackEnergyinJet.push_back( KaonTrackEnergyinJet );
+			result.protonTrackEnergyinJet.push_back( ProtonTrackEnergyinJet );
+			jetRecord.kaonTrackEnergyinJet = KaonTrackEnergyinJet;
+			jetRecord.protonTrackEnergyinJet = ProtonTrackEnergyinJet;
+			if ( acceptsJet( KaonTrackEnergyinJet , ProtonTrackEnergyinJet ) )
+			{
+				const double trueJetFourMomentum[ 4 ]{ trueJetP4[ 1 ] , trueJetP4[ 2 ] , trueJetP4[ 3 ] , trueJetP4[ 0 ] };
+				const double recoJetFourMomentum[ 4 ]{ recoJet->getMomentum()[ 0 ] , recoJet->getMomentum()[ 1 ] , recoJet->getMomentum()[ 2 ] , recoJet->getEnergy() };
+				if ( m_rebuildJetCovariance )
+				{
+					residualBatch.addJet( trueJetFourMomentum , jetCovarianceBuilder.fourMomentum() , jetCovarianceBuilder.covMatrix() );
+				}
+				else
+				{
+					residualBatch.addJet( trueJetFourMomentum , recoJetFourMomentum , recoJet->getCovMatrix().data() );
+				}
+				jetRecord.hasResiduals = 1;
+			}
+			result.jetRecords.push_back( jetRecord );
 		}
-		else
+		ScopedStageTimer residualTimer( statistics , ProcessorStatistics::kJetResiduals );
+		residualBatch.compute();
+
+		// the batch holds the jets with residuals in the order of their records; eventTree gets those of configuration 0
+		std::size_t i_residuals = 0;
+		for ( EventResult::JetRecord &jetRecord : result.jetRecords )
 		{
-			m_pionTrackEnergy.push_back( trackFourMomentum.E() );
-			m_pionTrackEnergyTotal += trackFourMomentum.E();
+			if ( !jetRecord.hasResiduals ) continue;
+			jetRecord.residuals = batchJetResiduals( residualBatch , i_residuals );
+			jetRecord.covariancePositiveDefinite = residualBatch.positiveDefinite( i_residuals );
+			if ( !jetRecord.covariancePositiveDefinite ) statistics.count( ProcessorStatistics::kJetsNonPositiveDefiniteCovariance );
+			++i_residuals;
+			if ( m_residualHistograms[ 0 ].accepts( jetRecord.kaonTrackEnergyinJet , jetRecord.protonTrackEnergyinJet ) ) appendJetResiduals( jetRecord.residuals , result );
 		}
+		residualTimer.stop();
 
 	}
 }
 
-int JetErrorAnalysis::getTrackIndex( EVENT::LCCollection *TrackCollection , EVENT::Track* inputTrk )
+void JetErrorAnalysis::commitEventResult( long long sequence , EventResult &result )
 {
-	LCCollection *MarlinTrkTracks{};
-	try
-	{
-		MarlinTrkTracks = TrackCollection;//pLCEvent->getCollection( TrackCollection );
-	}
-	catch (DataNotAvailableException &e)
+	std::unique_lock<std::mutex> lock( m_commitMutex );
+	m_commitCondition.wait( lock , [ this , sequence ]{ return sequence - m_nextCommitSequence < maxPendingResults(); } );
+	if ( sequence != m_nextCommitSequence )
 	{
-		streamlog_out(WARNING) << "	Could not find the " << TrackCollection << " Collection" << std::endl;
-		return -1;
-	}
-	unsigned int nTRKs = MarlinTrkTracks->getNumberOfElements();
-	int track_index = -1;
-	for (unsigned int i_trk = 0; i_trk < nTRKs;  ++i_trk )
-	{
-		Track* pionTrack = dynamic_cast<EVENT::Track*>( MarlinTrkTracks->getElementAt( i_trk ) );
-		if ( pionTrack == inputTrk )
+		// an earlier event is still being processed by another slot, park this one and hand the slot
+		// the storage of an already written result
+		EventResult &parkedResult = m_pendingResults[ sequence ];
+		if ( !m_spareResults.empty() )
 		{
-			track_index = i_trk;
+			std::swap( parkedResult , m_spareResults.back() );
+			m_spareResults.pop_back();
 		}
+		std::swap( parkedResult , result );
+		return;
 	}
-	if ( track_index == -1)
+	fillEventResult( result );
+	++m_nextCommitSequence;
+	std::map<long long,EventResult>::iterator pending = m_pendingResults.begin();
+	while ( pending != m_pendingResults.end() && pending->first == m_nextCommitSequence )
 	{
-		streamlog_out(DEBUG1) << "	Coudln't find track_index!!!  " << std::endl;
+		fillEventResult( pending->second );
+		++m_nextCommitSequence;
+		m_spareResults.push_back( std::move( pending->second ) );
+		pending = m_pendingResults.erase( pending );
 	}
-	else
+	m_commitCondition.notify_all();
+}
+
+void JetErrorAnalysis::fillEventResult( EventResult &result )
+{
+	if ( !result.accepted ) return;
+	std::swap( m_eventResult , result );
+	m_nRun = m_eventResult.run;
+	m_nEvt = m_eventResult.event;
+	fillHistograms( m_eventResult );
+	m_nEvtSum++;
+	m_nEvt++ ;
+	ScopedStageTimer fillTimer( m_commitStatistics , ProcessorStatistics::kTreeFill );
+	m_eventTreeWriter.fill();
+}
+
+void JetErrorAnalysis::fillHistograms( const EventResult &result )
+{
+	// the residuals of a jet are computed once and filled into every configuration whose cuts it passes
+	for ( const EventResult::JetRecord &jetRecord : result.jetRecords )
 	{
-		streamlog_out(DEBUG1) << "	Track index in " << m_MarlinTrkTracks << " collection is " << track_index << std::endl;
+		if ( !jetRecord.hasResiduals ) continue;
+		for ( ResidualHistogramSet &residualHistograms : m_residualHistograms )
+		{
+			if ( residualHistograms.accepts( jetRecord.kaonTrackEnergyinJet , jetRecord.protonTrackEnergyinJet ) ) residualHistograms.fill( jetRecord.residuals );
+		}
 	}
-	return track_index;
 }
 
+TH1F *JetErrorAnalysis::bookHistogram( const StreamingHistogram &streamingHistogram , const std::string &name , const std::string &title , const std::string &axisTitle ) const
+{
+	TH1F *histogram = ResidualHistogramOutput::book( streamingHistogram , name , title , axisTitle , m_nHistogramBins );
+	if ( streamingHistogram.invalidEntries() > 0 ) streamlog_out(WARNING) << "	" << streamingHistogram.invalidEntries() << " non-finite values were not filled in " << name << std::endl;
+	return histogram;
+}
 
-TLorentzVector JetErrorAnalysis::getTrackFourMomentum( EVENT::Track* inputTrk , double trackMass )
+void JetErrorAnalysis::fillTrackEnergies( const TrackClassifier &trackClassifier , double &KaonTrackEnergyinJet , double &ProtonTrackEnergyinJet , EventResult &result ) const
 {
-	streamlog_out(DEBUG1) << "	------------------------------------------------" << std::endl;
-	streamlog_out(DEBUG1) << "	Calculating PFO 4-momentum from track parameters" << std::endl;
-	streamlog_out(DEBUG1) << "	------------------------------------------------" << std::endl;
-	double Phi = inputTrk->getPhi();
-	double Omega = inputTrk->getOmega();
-	double tanLambda = inputTrk->getTanLambda();
-	streamlog_out(DEBUG0) << "	Track parameters obtained" << std::endl;
-	double pT = eB / fabs( Omega );
-	double px = pT * TMath::Cos( Phi );
-	double py = pT * TMath::Sin( Phi );
-	double pz = pT * tanLambda;
-	double E = sqrt( pow( trackMass , 2 ) + px * px + py * py + pz * pz);
-	streamlog_out(DEBUG0) << "	Track parameters is converted to (p,E)" << std::endl;
-	TLorentzVector trackFourMomentum( px , py , pz , E );
-	return trackFourMomentum;
+	double jetEnergy[ TrackSpeciesOutput::kNJetEnergies ]{ 0.0 , KaonTrackEnergyinJet , ProtonTrackEnergyinJet };
+	for ( unsigned int i_trk = 0 ; i_trk < trackClassifier.nTracks() ; ++i_trk )
+	{
+		const int species = trackClassifier.trackSpecies( i_trk );
+		const double energy = trackClassifier.trackEnergy( i_trk );
+		const TrackSpeciesOutput &output = m_trackSpeciesOutputs[ species ];
+		if ( output.energies ) ( result.*output.energies ).push_back( energy );
+		if ( output.total ) result.*output.total += energy;
+		result.speciesTrackEnergyTotal[ species ] += energy;
+		jetEnergy[ output.jetEnergy ] += energy;
+	}
+	KaonTrackEnergyinJet = jetEnergy[ TrackSpeciesOutput::kKaonJetEnergy ];
+	ProtonTrackEnergyinJet = jetEnergy[ TrackSpeciesOutput::kProtonJetEnergy ];
 }
 
 void JetErrorAnalysis::check()
@@ -669,25 +1008,12 @@ void JetErrorAnalysis::check()
 
 void JetErrorAnalysis::InitializeHistogram( TH1F *histogram , int scale , int color , int lineWidth , int markerSize , int markerStyle )
 {
-	histogram->Scale( 1.0 / scale );
-	histogram->SetLineColor( color );
-	histogram->SetLineWidth( lineWidth );
-	histogram->SetMarkerSize( markerSize );
-	histogram->SetMarkerStyle( markerStyle );
-	histogram->SetMarkerColor( color );
+	ResidualHistogramOutput::normalize( histogram , scale , color , lineWidth , markerSize , markerStyle );
 	float fit_range = 2.0;
 	float fit_min = -2.0;
 	float fit_max = 2.0;
-	doProperGaussianFit( histogram , fit_min , fit_max , fit_range );
-	histogram->GetFunction("gaus")->SetLineColor( color );
-	float y_max = 1.2 * histogram->GetMaximum();
-	histogram->GetYaxis()->SetRangeUser(0.0, y_max);
-	histogram->GetXaxis()->SetTitleSize(0.06);
-	histogram->GetXaxis()->SetTitleOffset(1.10);
-	histogram->GetXaxis()->SetLabelSize(0.06);
-	histogram->GetYaxis()->SetTitleSize(0.06);
-	histogram->GetYaxis()->SetTitleOffset(1.30);
-	histogram->GetYaxis()->SetLabelSize(0.06);
+	if ( doProperGaussianFit( histogram , fit_min , fit_max , fit_range ).valid ) histogram->GetFunction("gaus")->SetLineColor( color );
+	ResidualHistogramOutput::formatAxes( histogram );
 	histogram->Write();
 	/*
 	gPad->Update();
@@ -702,45 +1028,95 @@ void JetErrorAnalysis::InitializeHistogram( TH1F *histogram , int scale , int co
 */
 }
 
-void JetErrorAnalysis::doProperGaussianFit( TH1F *histogram , float fitMin , float fitMax , float fitRange )
+GaussianCoreFitter::Result JetErrorAnalysis::doProperGaussianFit( TH1F *histogram , float fitMin , float fitMax , float fitRange )
 {
-	float Chi2 = 0.0;
-	float NDF = 0.0;
-	for ( int i_fit = 0 ; i_fit < 3 ; ++i_fit )
-	{
-		histogram->Fit( "gaus" , "" , "" , fitMin , fitMax );
-		TF1 *fitFunction = (TF1 *)histogram->GetFunction("gaus");
-		double fitMean = fitFunction->GetParameter( 1 );
-		double fitSigma = fitFunction->GetParameter( 2 );
-		fitMin = fitMean - fitRange * fitSigma;
-		fitMax = fitMean + fitRange * fitSigma;
-		Chi2 = fitFunction->GetChisquare();
-		NDF = fitFunction->GetNDF();
+	const GaussianCoreFitter::Result result = ResidualHistogramOutput::fitGaussianCore( histogram , fitMin , fitMax , fitRange );
+	if ( !result.valid )
+	{
+		streamlog_out(WARNING) << "	FIT : no Gaussian core found in " << histogram->GetName() << std::endl;
+		return result;
 	}
-	streamlog_out(DEBUG4) << "	FIT : CHI2(" << Chi2 << ") / NDF(" << NDF << ") = " << Chi2 / NDF << " 	, fitrange = " << fitRange << std::endl;
-	streamlog_out(DEBUG4) << "" << std::endl;
-	if ( Chi2 != 0.0 && NDF != 0.0 && Chi2 / NDF > 2.0 && fitRange >= 0.5 )
+	streamlog_out(DEBUG4) << "	FIT : CHI2(" << result.chi2 << ") / NDF(" << result.ndf << ") = " << result.chi2 / result.ndf << " 	, fitrange = " << result.fitRange << " , passes = " << result.nPasses << std::endl;
+	streamlog_out(MESSAGE) << "	" << histogram->GetName() << " : mean = " << result.mean << " +- " << result.meanError << " , sigma = " << result.sigma << " +- " << result.sigmaError << std::endl;
+
+	if ( m_rootFitCrossCheck )
 	{
-		doProperGaussianFit( histogram , fitMin , fitMax , fitRange - 0.1 );
+		TF1 crossCheck( "crossCheck" , "gaus" , result.fitMin , result.fitMax , TF1::EAddToList::kNo );
+		crossCheck.SetParameters( result.constant , result.mean , result.sigma );
+		histogram->Fit( &crossCheck , "QNR" );
+		streamlog_out(MESSAGE) << "	" << histogram->GetName() << " : ROOT fit cross-check mean = " << crossCheck.GetParameter( 1 ) << " +- " << crossCheck.GetParError( 1 ) << " , sigma = " << crossCheck.GetParameter( 2 ) << " +- " << crossCheck.GetParError( 2 ) << " , CHI2 / NDF = " << crossCheck.GetChisquare() << " / " << crossCheck.GetNDF() << std::endl;
 	}
+	return result;
 }
 
 void JetErrorAnalysis::end()
 {
+	if ( !m_pendingResults.empty() )
+	{
+		streamlog_out(WARNING) << "	" << m_pendingResults.size() << " events were processed out of sequence, writing them in input order" << std::endl;
+		for ( std::pair<const long long,EventResult> &pending : m_pendingResults ) fillEventResult( pending.second );
+		m_pendingResults.clear();
+	}
+	ProcessorStatistics statistics( m_commitStatistics );
+	for ( unsigned int i_slot = 0 ; i_slot < m_workerSlots.size() ; ++i_slot )
+	{
+		const ProcessorStatistics &slotStatistics = m_workerSlots[ i_slot ]->eventContext.statistics();
+		streamlog_out(DEBUG4) << "	Slot " << i_slot << " : " << slotStatistics.counter( ProcessorStatistics::kEvents ) << " events, " << slotStatistics.seconds( ProcessorStatistics::kProcessEvent ) << " s in processEvent" << std::endl;
+		statistics.merge( slotStatistics );
+	}
+	const long long nSkippedEvents = statistics.counter( ProcessorStatistics::kEventsSkippedMissingInput ) + statistics.counter( ProcessorStatistics::kEventsSkippedDataNotAvailable );
+	streamlog_out(MESSAGE) << "	Processed " << statistics.counter( ProcessorStatistics::kEvents ) << " events in " << m_workerSlots.size() << " slot(s), " << nSkippedEvents << " skipped for missing input" << std::endl;
+	const long long nRejectedEvents = statistics.counter( ProcessorStatistics::kEventsRejectedJetMultiplicity ) + statistics.counter( ProcessorStatistics::kEventsRejectedPIDTracks );
+	if ( statistics.counter( ProcessorStatistics::kEvents ) > 0 )
+	{
+		streamlog_out(MESSAGE) << "	Pre-selection rejected " << nRejectedEvents << " events ( " << 100.0 * nRejectedEvents / statistics.counter( ProcessorStatistics::kEvents ) << "% )" << ( m_skipFillOnReject ? ", not written to eventTree" : "" ) << std::endl;
+	}
 	m_pTFile->cd();
 	m_pTTree->Write();
-	InitializeHistogram( h_ResidualPx , n_ResidualPx , m_histColour , 1 , 1.0 , 1 );
-	InitializeHistogram( h_ResidualPy , n_ResidualPy , m_histColour , 1 , 1.0 , 1 );
-	InitializeHistogram( h_ResidualPz , n_ResidualPz , m_histColour , 1 , 1.0 , 1 );
-	InitializeHistogram( h_ResidualE , n_ResidualE , m_histColour , 1 , 1.0 , 1 );
-	InitializeHistogram( h_ResidualTheta , n_ResidualTheta , m_histColour , 1 , 1.0 , 1 );
-	InitializeHistogram( h_ResidualPhi , n_ResidualPhi , m_histColour , 1 , 1.0 , 1 );
-	InitializeHistogram( h_NormalizedResidualPx , n_NormalizedResidualPx , m_histColour , 1 , 1.0 , 1 );
-	InitializeHistogram( h_NormalizedResidualPy , n_NormalizedResidualPy , m_histColour , 1 , 1.0 , 1 );
-	InitializeHistogram( h_NormalizedResidualPz , n_NormalizedResidualPz , m_histColour , 1 , 1.0 , 1 );
-	InitializeHistogram( h_NormalizedResidualE , n_NormalizedResidualE , m_histColour , 1 , 1.0 , 1 );
-	InitializeHistogram( h_NormalizedResidualTheta , n_NormalizedResidualTheta , m_histColour , 1 , 1.0 , 1 );
-	InitializeHistogram( h_NormalizedResidualPhi , n_NormalizedResidualPhi , m_histColour , 1 , 1.0 , 1 );
+	if ( m_eventTreeWriter.jetTree() != NULL ) m_eventTreeWriter.jetTree()->Write();
+	ScopedStageTimer fitTimer( statistics , ProcessorStatistics::kEndOfJobFit );
+	if ( m_writePartialHistograms )
+	{
+		std::vector<PartialHistogramTree::Entry> partialHistograms;
+		for ( const ResidualHistogramSet &residualHistograms : m_residualHistograms )
+		{
+			for ( int i_obs = 0 ; i_obs < JetResidualBatch::kNResiduals ; ++i_obs )
+			{
+				const JetResidualBatch::Residual observable = static_cast<JetResidualBatch::Residual>( i_obs );
+				partialHistograms.push_back( PartialHistogramTree::Entry{ residualHistograms.histogramName( observable ) , residualHistograms.title() , i_obs , residualHistograms.colour() , m_nHistogramBins , residualHistograms.nJets() , residualHistograms.histogram( observable ) } );
+			}
+		}
+		PartialHistogramTree::write( m_pTFile , partialHistograms );
+	}
+	else
+	{
+		for ( const ResidualHistogramSet &residualHistograms : m_residualHistograms )
+		{
+			TH1F *histograms[ JetResidualBatch::kNResiduals ];
+			for ( int i_obs = 0 ; i_obs < JetResidualBatch::kNResiduals ; ++i_obs )
+			{
+				const JetResidualBatch::Residual observable = static_cast<JetResidualBatch::Residual>( i_obs );
+				histograms[ i_obs ] = bookHistogram( residualHistograms.histogram( observable ) , residualHistograms.histogramName( observable ) , residualHistograms.title() , residualObservables[ i_obs ].axisTitle );
+			}
+			for ( int i_obs = 0 ; i_obs < JetResidualBatch::kNResiduals ; ++i_obs )
+			{
+				if ( residualObservables[ i_obs ].fitGaussianCore )
+				{
+					InitializeHistogram( histograms[ i_obs ] , residualHistograms.nJets() , residualHistograms.colour() , 1 , 1.0 , 1 );
+					continue;
+				}
+				// a chi2 has no Gaussian core, its mean over all entries is compared with the degrees of freedom
+				const StreamingHistogram &chi2 = residualHistograms.histogram( static_cast<JetResidualBatch::Residual>( i_obs ) );
+				ResidualHistogramOutput::normalize( histograms[ i_obs ] , residualHistograms.nJets() , residualHistograms.colour() , 1 , 1.0 , 1 );
+				streamlog_out(MESSAGE) << "	" << histograms[ i_obs ]->GetName() << " : mean chi2 / ndf = " << chi2.mean() / residualObservables[ i_obs ].nDegreesOfFreedom << " , ndf = " << residualObservables[ i_obs ].nDegreesOfFreedom << std::endl;
+				ResidualHistogramOutput::formatAxes( histograms[ i_obs ] );
+				histograms[ i_obs ]->Write();
+			}
+		}
+	}
+	fitTimer.stop();
+	streamlog_out(MESSAGE) << "	Processor statistics:" << std::endl << statistics.summary();
+	if ( m_writeStatisticsTree ) statistics.writeTree( m_pTFile );
 	m_pTFile->Close();
 	delete m_pTFile;
 
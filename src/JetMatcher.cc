@@ -0,0 +1,166 @@
+#include "JetMatcher.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void JetMatcher::clear()
+{
+	m_trueDirections.clear();
+	m_recoDirections.clear();
+	m_cosines.clear();
+	m_matchedRecoJets.clear();
+}
+
+void JetMatcher::addTrueJet( const double *momentum )
+{
+	addDirection( momentum , m_trueDirections );
+}
+
+void JetMatcher::addRecoJet( const double *momentum )
+{
+	addDirection( momentum , m_recoDirections );
+}
+
+void JetMatcher::addDirection( const double *momentum , std::vector<double> &directions )
+{
+	const double magnitude = std::sqrt( momentum[ 0 ] * momentum[ 0 ] + momentum[ 1 ] * momentum[ 1 ] + momentum[ 2 ] * momentum[ 2 ] );
+	const double scale = ( magnitude > 0.0 ? 1.0 / magnitude : 0.0 );
+	directions.push_back( momentum[ 0 ] * scale );
+	directions.push_back( momentum[ 1 ] * scale );
+	directions.push_back( momentum[ 2 ] * scale );
+}
+
+void JetMatcher::buildCosines()
+{
+	const std::size_t nTrue = nTrueJets();
+	const std::size_t nReco = nRecoJets();
+	m_cosines.resize( nTrue * nReco );
+	const double *trueDirection = m_trueDirections.data();
+	for ( std::size_t i_true = 0 ; i_true < nTrue ; ++i_true , trueDirection += 3 )
+	{
+		const double *recoDirection = m_recoDirections.data();
+		double *cosines = &m_cosines[ i_true * nReco ];
+		for ( std::size_t i_reco = 0 ; i_reco < nReco ; ++i_reco , recoDirection += 3 )
+		{
+			cosines[ i_reco ] = trueDirection[ 0 ] * recoDirection[ 0 ] + trueDirection[ 1 ] * recoDirection[ 1 ] + trueDirection[ 2 ] * recoDirection[ 2 ];
+		}
+	}
+}
+
+const std::vector<int> &JetMatcher::match( std::size_t maxEnumeratedJets )
+{
+	buildCosines();
+	m_matchedRecoJets.assign( nTrueJets() , -1 );
+	if ( nTrueJets() == 0 || nRecoJets() == 0 ) return m_matchedRecoJets;
+	if ( nTrueJets() <= nRecoJets() && nRecoJets() <= maxEnumeratedJets )
+	{
+		matchByEnumeration();
+	}
+	else
+	{
+		matchByHungarianMethod();
+	}
+	return m_matchedRecoJets;
+}
+
+void JetMatcher::matchByEnumeration()
+{
+	const std::size_t nTrue = nTrueJets();
+	const std::size_t nReco = nRecoJets();
+	m_permutation.resize( nReco );
+	for ( std::size_t i_reco = 0 ; i_reco < nReco ; ++i_reco ) m_permutation[ i_reco ] = i_reco;
+
+	// 6! = 720 orderings for kMaxEnumeratedJets reco jets; the first nTrue entries are the reco jets given to the true jets
+	double bestSum = -std::numeric_limits<double>::max();
+	do
+	{
+		double sum = 0.0;
+		for ( std::size_t i_true = 0 ; i_true < nTrue ; ++i_true ) sum += m_cosines[ i_true * nReco + m_permutation[ i_true ] ];
+		if ( sum > bestSum )
+		{
+			bestSum = sum;
+			std::copy( m_permutation.begin() , m_permutation.begin() + nTrue , m_matchedRecoJets.begin() );
+		}
+	}
+	while ( std::next_permutation( m_permutation.begin() , m_permutation.end() ) );
+}
+
+void JetMatcher::matchByHungarianMethod()
+{
+	// minimizes the summed -cosine; rows are the smaller set of jets so that every row gets a column
+	const std::size_t nTrue = nTrueJets();
+	const std::size_t nReco = nRecoJets();
+	const bool trueJetRows = ( nTrue <= nReco );
+	const std::size_t nRows = ( trueJetRows ? nTrue : nReco );
+	const std::size_t nColumns = ( trueJetRows ? nReco : nTrue );
+	const double infinity = std::numeric_limits<double>::max();
+
+	m_rowPotential.assign( nRows + 1 , 0.0 );
+	m_columnPotential.assign( nColumns + 1 , 0.0 );
+	m_columnMatch.assign( nColumns + 1 , 0 );
+	m_columnWay.assign( nColumns + 1 , 0 );
+	for ( std::size_t i_row = 1 ; i_row <= nRows ; ++i_row )
+	{
+		m_columnMatch[ 0 ] = i_row;
+		std::size_t j0 = 0;
+		m_minSlack.assign( nColumns + 1 , infinity );
+		m_columnUsed.assign( nColumns + 1 , 0 );
+		do
+		{
+			m_columnUsed[ j0 ] = 1;
+			const std::size_t i0 = m_columnMatch[ j0 ];
+			double delta = infinity;
+			std::size_t j1 = 0;
+			for ( std::size_t j = 1 ; j <= nColumns ; ++j )
+			{
+				if ( m_columnUsed[ j ] ) continue;
+				const double cost = -( trueJetRows ? m_cosines[ ( i0 - 1 ) * nReco + ( j - 1 ) ] : m_cosines[ ( j - 1 ) * nReco + ( i0 - 1 ) ] );
+				const double slack = cost - m_rowPotential[ i0 ] - m_columnPotential[ j ];
+				if ( slack < m_minSlack[ j ] )
+				{
+					m_minSlack[ j ] = slack;
+					m_columnWay[ j ] = j0;
+				}
+				if ( m_minSlack[ j ] < delta )
+				{
+					delta = m_minSlack[ j ];
+					j1 = j;
+				}
+			}
+			for ( std::size_t j = 0 ; j <= nColumns ; ++j )
+			{
+				if ( m_columnUsed[ j ] )
+				{
+					m_rowPotential[ m_columnMatch[ j ] ] += delta;
+					m_columnPotential[ j ] -= delta;
+				}
+				else
+				{
+					m_minSlack[ j ] -= delta;
+				}
+			}
+			j0 = j1;
+		}
+		while ( m_columnMatch[ j0 ] != 0 );
+		do
+		{
+			const std::size_t j1 = m_columnWay[ j0 ];
+			m_columnMatch[ j0 ] = m_columnMatch[ j1 ];
+			j0 = j1;
+		}
+		while ( j0 != 0 );
+	}
+
+	for ( std::size_t j = 1 ; j <= nColumns ; ++j )
+	{
+		if ( m_columnMatch[ j ] == 0 ) continue;
+		if ( trueJetRows )
+		{
+			m_matchedRecoJets[ m_columnMatch[ j ] - 1 ] = j - 1;
+		}
+		else
+		{
+			m_matchedRecoJets[ j - 1 ] = m_columnMatch[ j ] - 1;
+		}
+	}
+}
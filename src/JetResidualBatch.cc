@@ -0,0 +1,182 @@
+#include "JetResidualBatch.h"
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	/*
+	* Cholesky factor L of the ( px , py , pz , E ) covariance V of every jet, lower triangle a_ij of V,
+	* and forward substitution z = L^-1 r of the residual r. Arithmetic only so the loop vectorizes; a
+	* non-positive pivot makes all results of the jet NaN without a branch.
+	*/
+	void choleskyPulls(	std::size_t nJets , const double *__restrict r0 , const double *__restrict r1 , const double *__restrict r2 , const double *__restrict r3 ,
+				const double *__restrict a00 , const double *__restrict a10 , const double *__restrict a11 , const double *__restrict a20 , const double *__restrict a21 ,
+				const double *__restrict a22 , const double *__restrict a30 , const double *__restrict a31 , const double *__restrict a32 , const double *__restrict a33 ,
+				double *__restrict chi2 , double *__restrict z0 , double *__restrict z1 , double *__restrict z2 , double *__restrict z3 )
+	{
+		const double nan = std::numeric_limits<double>::quiet_NaN();
+		for ( std::size_t i_jet = 0 ; i_jet < nJets ; ++i_jet )
+		{
+			const double d0 = a00[ i_jet ];
+			const double l00 = std::sqrt( d0 );
+			const double l10 = a10[ i_jet ] / l00;
+			const double l20 = a20[ i_jet ] / l00;
+			const double l30 = a30[ i_jet ] / l00;
+			const double d1 = a11[ i_jet ] - l10 * l10;
+			const double l11 = std::sqrt( d1 );
+			const double l21 = ( a21[ i_jet ] - l20 * l10 ) / l11;
+			const double l31 = ( a31[ i_jet ] - l30 * l10 ) / l11;
+			const double d2 = a22[ i_jet ] - l20 * l20 - l21 * l21;
+			const double l22 = std::sqrt( d2 );
+			const double l32 = ( a32[ i_jet ] - l30 * l20 - l31 * l21 ) / l22;
+			const double d3 = a33[ i_jet ] - l30 * l30 - l31 * l31 - l32 * l32;
+			const double l33 = std::sqrt( d3 );
+			const double y0 = r0[ i_jet ] / l00;
+			const double y1 = ( r1[ i_jet ] - l10 * y0 ) / l11;
+			const double y2 = ( r2[ i_jet ] - l20 * y0 - l21 * y1 ) / l22;
+			const double y3 = ( r3[ i_jet ] - l30 * y0 - l31 * y1 - l32 * y2 ) / l33;
+			// a select between two constants vectorizes, one between computed values and NaN does not
+			const bool valid = ( d0 > 0.0 ) & ( d1 > 0.0 ) & ( d2 > 0.0 ) & ( d3 > 0.0 );
+			const double invalid = ( valid ? 0.0 : nan );
+			z0[ i_jet ] = y0 + invalid;
+			z1[ i_jet ] = y1 + invalid;
+			z2[ i_jet ] = y2 + invalid;
+			z3[ i_jet ] = y3 + invalid;
+			chi2[ i_jet ] = y0 * y0 + y1 * y1 + y2 * y2 + y3 * y3 + invalid;
+		}
+	}
+}
+
+void JetResidualBatch::clear()
+{
+	m_truePx.clear();
+	m_truePy.clear();
+	m_truePz.clear();
+	m_trueE.clear();
+	m_recoPx.clear();
+	m_recoPy.clear();
+	m_recoPz.clear();
+	m_recoE.clear();
+	m_sigmaPx2.clear();
+	m_sigmaPxPy.clear();
+	m_sigmaPy2.clear();
+	m_sigmaPxPz.clear();
+	m_sigmaPyPz.clear();
+	m_sigmaPz2.clear();
+	m_sigmaPxE.clear();
+	m_sigmaPyE.clear();
+	m_sigmaPzE.clear();
+	m_sigmaE2.clear();
+	for ( std::vector<double> &residuals : m_residuals ) residuals.clear();
+}
+
+void JetResidualBatch::addJet( const double *trueFourMomentum , const double *recoFourMomentum , const float *covMatrix )
+{
+	m_truePx.push_back( trueFourMomentum[ 0 ] );
+	m_truePy.push_back( trueFourMomentum[ 1 ] );
+	m_truePz.push_back( trueFourMomentum[ 2 ] );
+	m_trueE.push_back( trueFourMomentum[ 3 ] );
+	m_recoPx.push_back( recoFourMomentum[ 0 ] );
+	m_recoPy.push_back( recoFourMomentum[ 1 ] );
+	m_recoPz.push_back( recoFourMomentum[ 2 ] );
+	m_recoE.push_back( recoFourMomentum[ 3 ] );
+	m_sigmaPx2.push_back( covMatrix[ 0 ] );
+	m_sigmaPxPy.push_back( covMatrix[ 1 ] );
+	m_sigmaPy2.push_back( covMatrix[ 2 ] );
+	m_sigmaPxPz.push_back( covMatrix[ 3 ] );
+	m_sigmaPyPz.push_back( covMatrix[ 4 ] );
+	m_sigmaPz2.push_back( covMatrix[ 5 ] );
+	m_sigmaPxE.push_back( covMatrix[ 6 ] );
+	m_sigmaPyE.push_back( covMatrix[ 7 ] );
+	m_sigmaPzE.push_back( covMatrix[ 8 ] );
+	m_sigmaE2.push_back( covMatrix[ 9 ] );
+}
+
+void JetResidualBatch::compute()
+{
+	const std::size_t nJets = size();
+	for ( std::vector<double> &residuals : m_residuals ) residuals.resize( nJets );
+
+	const double *__restrict truePx = m_truePx.data();
+	const double *__restrict truePy = m_truePy.data();
+	const double *__restrict truePz = m_truePz.data();
+	const double *__restrict trueE = m_trueE.data();
+	const double *__restrict recoPx = m_recoPx.data();
+	const double *__restrict recoPy = m_recoPy.data();
+	const double *__restrict recoPz = m_recoPz.data();
+	const double *__restrict recoE = m_recoE.data();
+	const double *__restrict sigmaPx2 = m_sigmaPx2.data();
+	const double *__restrict sigmaPxPy = m_sigmaPxPy.data();
+	const double *__restrict sigmaPy2 = m_sigmaPy2.data();
+	const double *__restrict sigmaPxPz = m_sigmaPxPz.data();
+	const double *__restrict sigmaPyPz = m_sigmaPyPz.data();
+	const double *__restrict sigmaPz2 = m_sigmaPz2.data();
+	const double *__restrict sigmaE2 = m_sigmaE2.data();
+	double *__restrict residualPx = m_residuals[ kPx ].data();
+	double *__restrict residualPy = m_residuals[ kPy ].data();
+	double *__restrict residualPz = m_residuals[ kPz ].data();
+	double *__restrict residualE = m_residuals[ kE ].data();
+	double *__restrict residualTheta = m_residuals[ kTheta ].data();
+	double *__restrict residualPhi = m_residuals[ kPhi ].data();
+	double *__restrict normalizedPx = m_residuals[ kNormalizedPx ].data();
+	double *__restrict normalizedPy = m_residuals[ kNormalizedPy ].data();
+	double *__restrict normalizedPz = m_residuals[ kNormalizedPz ].data();
+	double *__restrict normalizedE = m_residuals[ kNormalizedE ].data();
+	// the normalized theta/phi arrays hold the propagated sigmas until the second loop
+	double *__restrict sigmaTheta = m_residuals[ kNormalizedTheta ].data();
+	double *__restrict sigmaPhi = m_residuals[ kNormalizedPhi ].data();
+
+	// arithmetic only: momentum residuals and error propagation to theta and phi, vectorizes
+	for ( std::size_t i_jet = 0 ; i_jet < nJets ; ++i_jet )
+	{
+		const double px = recoPx[ i_jet ];
+		const double py = recoPy[ i_jet ];
+		const double pz = recoPz[ i_jet ];
+		const double pt2 = px * px + py * py;
+		const double p2 = pt2 + pz * pz;
+		const double pt = std::sqrt( pt2 );
+		const double dTheta_dPx = px * pz / ( p2 * pt );
+		const double dTheta_dPy = py * pz / ( p2 * pt );
+		const double dTheta_dPz = -pt / p2;
+		const double dPhi_dPx = -py / pt2;
+		const double dPhi_dPy = px / pt2;
+		residualPx[ i_jet ] = px - truePx[ i_jet ];
+		residualPy[ i_jet ] = py - truePy[ i_jet ];
+		residualPz[ i_jet ] = pz - truePz[ i_jet ];
+		residualE[ i_jet ] = recoE[ i_jet ] - trueE[ i_jet ];
+		normalizedPx[ i_jet ] = residualPx[ i_jet ] / std::sqrt( sigmaPx2[ i_jet ] );
+		normalizedPy[ i_jet ] = residualPy[ i_jet ] / std::sqrt( sigmaPy2[ i_jet ] );
+		normalizedPz[ i_jet ] = residualPz[ i_jet ] / std::sqrt( sigmaPz2[ i_jet ] );
+		normalizedE[ i_jet ] = residualE[ i_jet ] / std::sqrt( sigmaE2[ i_jet ] );
+		sigmaTheta[ i_jet ] = std::sqrt( std::fabs(	sigmaPx2[ i_jet ] * dTheta_dPx * dTheta_dPx + sigmaPy2[ i_jet ] * dTheta_dPy * dTheta_dPy + sigmaPz2[ i_jet ] * dTheta_dPz * dTheta_dPz +
+								2 * ( sigmaPxPy[ i_jet ] * dTheta_dPx * dTheta_dPy ) + 2 * ( sigmaPxPz[ i_jet ] * dTheta_dPx * dTheta_dPz ) + 2 * ( sigmaPyPz[ i_jet ] * dTheta_dPy * dTheta_dPz ) ) );
+		sigmaPhi[ i_jet ] = std::sqrt( std::fabs( sigmaPx2[ i_jet ] * dPhi_dPx * dPhi_dPx + sigmaPy2[ i_jet ] * dPhi_dPy * dPhi_dPy + 2 * ( sigmaPxPy[ i_jet ] * dPhi_dPx * dPhi_dPy ) ) );
+	}
+
+	// angular residuals, one atan2 per angle instead of unit vectors and acos
+	for ( std::size_t i_jet = 0 ; i_jet < nJets ; ++i_jet )
+	{
+		const double trueRho = std::sqrt( truePx[ i_jet ] * truePx[ i_jet ] + truePy[ i_jet ] * truePy[ i_jet ] );
+		const double recoRho = std::sqrt( recoPx[ i_jet ] * recoPx[ i_jet ] + recoPy[ i_jet ] * recoPy[ i_jet ] );
+
+		// signed angle between the jets after rotating the reco jet to the azimuth of the true jet
+		const double thetaResidual = std::atan2( recoRho * truePz[ i_jet ] - recoPz[ i_jet ] * trueRho , recoRho * trueRho + recoPz[ i_jet ] * truePz[ i_jet ] );
+
+		// signed opening angle in the transverse plane; the previous code signed it with the unwrapped
+		// phi difference, which flips the sign when the shorter arc crosses the phi = +-pi cut
+		const double transverseCross = truePx[ i_jet ] * recoPy[ i_jet ] - truePy[ i_jet ] * recoPx[ i_jet ];
+		const double transverseAngle = std::atan2( transverseCross , truePx[ i_jet ] * recoPx[ i_jet ] + truePy[ i_jet ] * recoPy[ i_jet ] );
+		const bool crossesPhiCut = ( truePy[ i_jet ] * recoPy[ i_jet ] < 0 ) && ( transverseCross * ( recoPy[ i_jet ] - truePy[ i_jet ] ) < 0 );
+		const double phiResidual = ( crossesPhiCut ? -transverseAngle : transverseAngle );
+
+		residualTheta[ i_jet ] = thetaResidual;
+		residualPhi[ i_jet ] = phiResidual;
+		sigmaTheta[ i_jet ] = thetaResidual / sigmaTheta[ i_jet ];
+		sigmaPhi[ i_jet ] = phiResidual / sigmaPhi[ i_jet ];
+	}
+
+	// joint consistency of the four residuals with the full covariance
+	choleskyPulls(	nJets , residualPx , residualPy , residualPz , residualE ,
+			sigmaPx2 , sigmaPxPy , sigmaPy2 , sigmaPxPz , sigmaPyPz , sigmaPz2 , m_sigmaPxE.data() , m_sigmaPyE.data() , m_sigmaPzE.data() , sigmaE2 ,
+			m_residuals[ kCovarianceChi2 ].data() , m_residuals[ kDecorrelatedPx ].data() , m_residuals[ kDecorrelatedPy ].data() , m_residuals[ kDecorrelatedPz ].data() , m_residuals[ kDecorrelatedE ].data() );
+}
@@ -0,0 +1,111 @@
+#include "MCParticleAncestry.h"
+#include <cstdlib>
+#include <initializer_list>
+
+void MCParticleAncestry::clear()
+{
+	m_index.clear();
+	m_particles.clear();
+	m_nodes.clear();
+	m_nSemileptonicB = 0;
+	m_nSemileptonicC = 0;
+}
+
+int MCParticleAncestry::hadronFlavour( int pdg )
+{
+	// PDG numbering: ...n_q1 n_q2 n_q3 n_J, n_q1 = 0 for mesons; n_q3 = 0 are diquarks, ten digits are nuclei
+	const int code = std::abs( pdg );
+	if ( code < 100 || code >= 1000000000 ) return kLight;
+	const int nq3 = ( code / 10 ) % 10;
+	if ( nq3 == 0 ) return kLight;
+	int flavour = kLight;
+	for ( int nq : { ( code / 1000 ) % 10 , ( code / 100 ) % 10 , nq3 } )
+	{
+		if ( nq == kBottom ) return kBottom;
+		if ( nq == kCharm ) flavour = kCharm;
+	}
+	return flavour;
+}
+
+void MCParticleAncestry::build( EVENT::LCCollection *mcParticleCollection )
+{
+	const unsigned int nMCPs = ( mcParticleCollection != NULL ? mcParticleCollection->getNumberOfElements() : 0 );
+
+	clear();
+	m_index.reserve( nMCPs );
+	for ( unsigned int i_mcp = 0 ; i_mcp < nMCPs ; ++i_mcp )
+	{
+		const EVENT::MCParticle *mcParticle = dynamic_cast<EVENT::MCParticle*>( mcParticleCollection->getElementAt( i_mcp ) );
+		if ( mcParticle == NULL || find( mcParticle ) != -1 ) continue;
+		m_index.insert( mcParticle , m_particles.size() );
+		m_particles.push_back( mcParticle );
+	}
+	m_nodes.resize( m_particles.size() );
+	m_visited.assign( m_particles.size() , 0 );
+	for ( unsigned int i_mcp = 0 ; i_mcp < m_particles.size() ; ++i_mcp ) visit( i_mcp );
+}
+
+void MCParticleAncestry::visit( int i_mcp )
+{
+	// iterative depth-first search over the parents: a particle is completed once all of its parents are,
+	// so every particle is completed exactly once whatever the order of the collection
+	enum { kNew = 0 , kOpen , kDone };
+	if ( m_visited[ i_mcp ] == kDone ) return;
+	m_stack.clear();
+	m_stack.push_back( i_mcp );
+	while ( !m_stack.empty() )
+	{
+		const int i_top = m_stack.back();
+		const EVENT::MCParticle *mcParticle = m_particles[ i_top ];
+		if ( m_visited[ i_top ] == kDone )
+		{
+			m_stack.pop_back();
+			continue;
+		}
+		if ( m_visited[ i_top ] == kNew )
+		{
+			m_visited[ i_top ] = kOpen;
+			for ( const EVENT::MCParticle *parent : mcParticle->getParents() )
+			{
+				const int i_parent = find( parent );
+				if ( i_parent != -1 && m_visited[ i_parent ] == kNew ) m_stack.push_back( i_parent );
+			}
+			continue;
+		}
+
+		// all parents are done, except those closing a loop in a broken record, which are ignored
+		m_stack.pop_back();
+		m_visited[ i_top ] = kDone;
+		const int flavour = hadronFlavour( mcParticle->getPDG() );
+		Node node{ flavour , ( flavour != kLight ? i_top : -1 ) , 0 };
+		for ( const EVENT::MCParticle *parent : mcParticle->getParents() )
+		{
+			const int i_parent = find( parent );
+			if ( i_parent == -1 || m_visited[ i_parent ] != kDone ) continue;
+			const Node &parentNode = m_nodes[ i_parent ];
+			node.flags |= parentNode.flags & ( kFromSemileptonicB | kFromSemileptonicC );
+			if ( parentNode.flavour > node.flavour )
+			{
+				node.flavour = parentNode.flavour;
+				node.heaviestAncestor = parentNode.heaviestAncestor;
+			}
+		}
+		if ( flavour != kLight )
+		{
+			bool chargedLepton = false;
+			bool neutrino = false;
+			for ( const EVENT::MCParticle *daughter : mcParticle->getDaughters() )
+			{
+				const int daughterPDG = std::abs( daughter->getPDG() );
+				chargedLepton = chargedLepton || daughterPDG == 11 || daughterPDG == 13 || daughterPDG == 15;
+				neutrino = neutrino || daughterPDG == 12 || daughterPDG == 14 || daughterPDG == 16;
+			}
+			if ( chargedLepton && neutrino )
+			{
+				node.flags |= kSemileptonicDecay | semileptonicFlag( flavour );
+				++( flavour == kBottom ? m_nSemileptonicB : m_nSemileptonicC );
+			}
+		}
+		m_nodes[ i_top ] = node;
+	}
+}
@@ -0,0 +1,101 @@
+#include "PartialHistogramTree.h"
+#include <cstdio>
+#include <string>
+#include "TBranch.h"
+#include "TFile.h"
+#include "TTree.h"
+
+const char *PartialHistogramTree::treeName = "partialResidualHistograms";
+
+namespace
+{
+	const int kMaxNameLength = 256;
+}
+
+void PartialHistogramTree::write( TFile *file , const std::vector<Entry> &entries )
+{
+	char name[ kMaxNameLength ]{};
+	char title[ kMaxNameLength ]{};
+	int observable = 0;
+	int colour = 0;
+	int maxBins = 0;
+	Long64_t nJets = 0;
+	int nStateValues = StreamingHistogram::kNStateValues;
+	std::vector<double> state( StreamingHistogram::kNStateValues );
+	TTree *tree = new TTree( treeName , treeName );
+	tree->SetDirectory( file );
+	tree->Branch( "name" , name , "name/C" );
+	tree->Branch( "title" , title , "title/C" );
+	tree->Branch( "observable" , &observable , "observable/I" );
+	tree->Branch( "colour" , &colour , "colour/I" );
+	tree->Branch( "maxBins" , &maxBins , "maxBins/I" );
+	tree->Branch( "nJets" , &nJets , "nJets/L" );
+	tree->Branch( "nStateValues" , &nStateValues , "nStateValues/I" );
+	tree->Branch( "state" , state.data() , ( "state[" + std::to_string( StreamingHistogram::kNStateValues ) + "]/D" ).c_str() );
+	for ( const Entry &entry : entries )
+	{
+		std::snprintf( name , sizeof( name ) , "%s" , entry.name.c_str() );
+		std::snprintf( title , sizeof( title ) , "%s" , entry.title.c_str() );
+		observable = entry.observable;
+		colour = entry.colour;
+		maxBins = entry.maxBins;
+		nJets = entry.nJets;
+		entry.histogram.getState( state.data() );
+		tree->Fill();
+	}
+	file->cd();
+	tree->Write();
+}
+
+bool PartialHistogramTree::read( TFile *file , std::vector<Entry> &entries )
+{
+	TTree *tree = NULL;
+	file->GetObject( treeName , tree );
+	if ( tree == NULL ) return false;
+	char name[ kMaxNameLength ]{};
+	char title[ kMaxNameLength ]{};
+	int observable = 0;
+	int colour = 0;
+	int maxBins = 0;
+	Long64_t nJets = 0;
+	int nStateValues = 0;
+	std::vector<double> state( StreamingHistogram::kNStateValues );
+	tree->SetBranchAddress( "nStateValues" , &nStateValues );
+	if ( tree->GetEntries() > 0 )
+	{
+		tree->GetBranch( "nStateValues" )->GetEntry( 0 );
+		if ( nStateValues != StreamingHistogram::kNStateValues ) return false;
+	}
+	tree->SetBranchAddress( "name" , name );
+	tree->SetBranchAddress( "title" , title );
+	tree->SetBranchAddress( "observable" , &observable );
+	tree->SetBranchAddress( "colour" , &colour );
+	tree->SetBranchAddress( "maxBins" , &maxBins );
+	tree->SetBranchAddress( "nJets" , &nJets );
+	tree->SetBranchAddress( "state" , state.data() );
+	for ( Long64_t i_entry = 0 ; i_entry < tree->GetEntries() ; ++i_entry )
+	{
+		tree->GetEntry( i_entry );
+		entries.push_back( Entry{ name , title , observable , colour , maxBins , nJets , StreamingHistogram() } );
+		entries.back().histogram.setState( state.data() );
+	}
+	tree->ResetBranchAddresses();
+	return true;
+}
+
+void PartialHistogramTree::merge( std::vector<Entry> &merged , const std::vector<Entry> &entries )
+{
+	for ( const Entry &entry : entries )
+	{
+		bool found = false;
+		for ( Entry &mergedEntry : merged )
+		{
+			if ( mergedEntry.name != entry.name ) continue;
+			mergedEntry.nJets += entry.nJets;
+			mergedEntry.histogram.merge( entry.histogram );
+			found = true;
+			break;
+		}
+		if ( !found ) merged.push_back( entry );
+	}
+}
@@ -0,0 +1,87 @@
+#include "ProcessorStatistics.h"
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include "TFile.h"
+#include "TTree.h"
+
+const char *ProcessorStatistics::stageName( Stage stage )
+{
+	static const char *stageNames[ kNStages ]{ "processEvent" , "TrueJet_Parser::getall" , "jet matching" , "MCParticle loop" , "track classification" , "jet residuals" , "TTree::Fill" , "end-of-job fit" };
+	return stageNames[ stage ];
+}
+
+const char *ProcessorStatistics::counterName( Counter counter )
+{
+	static const char *counterNames[ kNCounters ]{ "events" , "PFOs visited" , "tracks classified" , "tracks, default species" , "jets skipped, PFO lists differ" , "jets, covariance not pos. definite" , "events skipped, missing input" , "events skipped, DataNotAvailable" , "events rejected, jet multiplicity" , "events rejected, PID tracks" , "events, species collection missing" };
+	return counterNames[ counter ];
+}
+
+void ProcessorStatistics::merge( const ProcessorStatistics &other )
+{
+	for ( int i_stage = 0 ; i_stage < kNStages ; ++i_stage )
+	{
+		m_stageTimes[ i_stage ] += other.m_stageTimes[ i_stage ];
+		m_stageCalls[ i_stage ] += other.m_stageCalls[ i_stage ];
+	}
+	for ( int i_counter = 0 ; i_counter < kNCounters ; ++i_counter ) m_counters[ i_counter ] += other.m_counters[ i_counter ];
+}
+
+void ProcessorStatistics::clear()
+{
+	m_stageTimes.fill( std::chrono::steady_clock::duration::zero() );
+	m_stageCalls.fill( 0 );
+	m_counters.fill( 0 );
+}
+
+std::string ProcessorStatistics::summary() const
+{
+	const double processEventSeconds = seconds( kProcessEvent );
+	std::ostringstream table;
+	table << std::fixed;
+	table << "	" << std::left << std::setw( 34 ) << "stage" << std::right << std::setw( 12 ) << "calls" << std::setw( 14 ) << "total [s]" << std::setw( 14 ) << "per call [us]" << std::setw( 10 ) << "share" << std::endl;
+	for ( int i_stage = 0 ; i_stage < kNStages ; ++i_stage )
+	{
+		const Stage stage = static_cast<Stage>( i_stage );
+		table << "	" << std::left << std::setw( 34 ) << stageName( stage ) << std::right << std::setw( 12 ) << calls( stage );
+		table << std::setprecision( 3 ) << std::setw( 14 ) << seconds( stage );
+		table << std::setprecision( 2 ) << std::setw( 14 ) << ( calls( stage ) > 0 ? 1e6 * seconds( stage ) / calls( stage ) : 0.0 );
+		if ( stage != kEndOfJobFit && processEventSeconds > 0.0 ) table << std::setprecision( 1 ) << std::setw( 9 ) << 100.0 * seconds( stage ) / processEventSeconds << "%";
+		table << std::endl;
+	}
+	for ( int i_counter = 0 ; i_counter < kNCounters ; ++i_counter )
+	{
+		const Counter counter = static_cast<Counter>( i_counter );
+		table << "	" << std::left << std::setw( 34 ) << counterName( counter ) << std::right << std::setw( 12 ) << this->counter( counter ) << std::endl;
+	}
+	return table.str();
+}
+
+void ProcessorStatistics::writeTree( TFile *file ) const
+{
+	char name[ 64 ]{};
+	Long64_t nCalls = 0;
+	double nSeconds = 0.0;
+	TTree *tree = new TTree( "processorStatistics" , "processorStatistics" );
+	tree->SetDirectory( file );
+	tree->Branch( "name" , name , "name/C" );
+	tree->Branch( "calls" , &nCalls , "calls/L" );
+	tree->Branch( "seconds" , &nSeconds , "seconds/D" );
+	for ( int i_stage = 0 ; i_stage < kNStages ; ++i_stage )
+	{
+		const Stage stage = static_cast<Stage>( i_stage );
+		std::snprintf( name , sizeof( name ) , "%s" , stageName( stage ) );
+		nCalls = calls( stage );
+		nSeconds = seconds( stage );
+		tree->Fill();
+	}
+	for ( int i_counter = 0 ; i_counter < kNCounters ; ++i_counter )
+	{
+		const Counter counter = static_cast<Counter>( i_counter );
+		std::snprintf( name , sizeof( name ) , "%s" , counterName( counter ) );
+		nCalls = this->counter( counter );
+		nSeconds = 0.0;
+		tree->Fill();
+	}
+	tree->Write();
+}
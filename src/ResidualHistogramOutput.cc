@@ -0,0 +1,65 @@
+#include "ResidualHistogramOutput.h"
+#include <sstream>
+#include <vector>
+#include "TF1.h"
+#include "TH1F.h"
+#include "TList.h"
+
+TH1F *ResidualHistogramOutput::book( const StreamingHistogram &streamingHistogram , const std::string &name , const std::string &title , const std::string &axisTitle , int maxBins )
+{
+	TH1F *histogram = streamingHistogram.makeTH1F( name , title + "; " + axisTitle , maxBins );
+	std::ostringstream yAxisTitle;
+	yAxisTitle << "Normalized Entries / " << histogram->GetXaxis()->GetBinWidth( 1 );
+	histogram->GetYaxis()->SetTitle( yAxisTitle.str().c_str() );
+	return histogram;
+}
+
+void ResidualHistogramOutput::normalize( TH1F *histogram , double scale , int color , int lineWidth , int markerSize , int markerStyle )
+{
+	histogram->Scale( 1.0 / scale );
+	histogram->SetLineColor( color );
+	histogram->SetLineWidth( lineWidth );
+	histogram->SetMarkerSize( markerSize );
+	histogram->SetMarkerStyle( markerStyle );
+	histogram->SetMarkerColor( color );
+}
+
+GaussianCoreFitter::Result ResidualHistogramOutput::fitGaussianCore( TH1F *histogram , float fitMin , float fitMax , float fitRange )
+{
+	const int nBins = histogram->GetNbinsX();
+	std::vector<double> binCenters( nBins );
+	std::vector<double> binContents( nBins );
+	std::vector<double> binErrors( nBins );
+	for ( int i_bin = 0 ; i_bin < nBins ; ++i_bin )
+	{
+		binCenters[ i_bin ] = histogram->GetXaxis()->GetBinCenter( i_bin + 1 );
+		binContents[ i_bin ] = histogram->GetBinContent( i_bin + 1 );
+		binErrors[ i_bin ] = histogram->GetBinError( i_bin + 1 );
+	}
+	GaussianCoreFitter gaussianCoreFitter;
+	gaussianCoreFitter.setBins( binCenters , binContents , binErrors );
+	const GaussianCoreFitter::Result result = gaussianCoreFitter.fit( fitMin , fitMax , fitRange );
+	if ( !result.valid ) return result;
+
+	// stored with the histogram in place of the ROOT fit result
+	TF1 *gaussian = new TF1( "gaus" , "gaus" , result.fitMin , result.fitMax , TF1::EAddToList::kNo );
+	gaussian->SetParameters( result.constant , result.mean , result.sigma );
+	gaussian->SetParError( 1 , result.meanError );
+	gaussian->SetParError( 2 , result.sigmaError );
+	gaussian->SetChisquare( result.chi2 );
+	gaussian->SetNDF( result.ndf );
+	histogram->GetListOfFunctions()->Add( gaussian );
+	return result;
+}
+
+void ResidualHistogramOutput::formatAxes( TH1F *histogram )
+{
+	float y_max = 1.2 * histogram->GetMaximum();
+	histogram->GetYaxis()->SetRangeUser(0.0, y_max);
+	histogram->GetXaxis()->SetTitleSize(0.06);
+	histogram->GetXaxis()->SetTitleOffset(1.10);
+	histogram->GetXaxis()->SetLabelSize(0.06);
+	histogram->GetYaxis()->SetTitleSize(0.06);
+	histogram->GetYaxis()->SetTitleOffset(1.30);
+	histogram->GetYaxis()->SetLabelSize(0.06);
+}
@@ -0,0 +1,19 @@
+#include "ResidualHistogramSet.h"
+
+ResidualHistogramSet::ResidualHistogramSet( const std::string &title , int colour , float minKaonTrackEnergy , float minProtonTrackEnergy , const std::string &suffix ) :
+m_title(title),
+m_colour(colour),
+m_minKaonTrackEnergy(minKaonTrackEnergy),
+m_minProtonTrackEnergy(minProtonTrackEnergy),
+m_suffix(suffix)
+{
+}
+
+void ResidualHistogramSet::fill( const EventResult::JetResiduals &jetResiduals )
+{
+	for ( int i_obs = 0 ; i_obs < JetResidualBatch::kNResiduals ; ++i_obs )
+	{
+		m_histograms[ i_obs ].fill( jetResiduals[ i_obs ] );
+	}
+	++m_nJets;
+}
@@ -0,0 +1,222 @@
+#include "StreamingHistogram.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "TH1F.h"
+
+void StreamingHistogram::reset()
+{
+	*this = StreamingHistogram();
+}
+
+int StreamingHistogram::magnitudeBin( double magnitude )
+{
+	if ( magnitude < std::ldexp( 1.0 , kMinExponent ) ) return -1;
+	int exponent = 0;
+	const double fraction = std::frexp( magnitude , &exponent );
+	const int octave = exponent - 1 - kMinExponent;
+	if ( octave >= kNOctaves ) return kNSignedBins;
+	const int subBin = std::min( static_cast<int>( ( 2.0 * fraction - 1.0 ) * kNSubBins ) , kNSubBins - 1 );
+	return octave * kNSubBins + subBin;
+}
+
+double StreamingHistogram::magnitudeBinLowEdge( int bin )
+{
+	const int octave = bin / kNSubBins;
+	const int subBin = bin % kNSubBins;
+	return std::ldexp( 1.0 + static_cast<double>( subBin ) / kNSubBins , octave + kMinExponent );
+}
+
+void StreamingHistogram::fill( double value )
+{
+	if ( !std::isfinite( value ) )
+	{
+		++m_nInvalid;
+		return;
+	}
+	m_min = ( m_entries == 0 ? value : std::min( m_min , value ) );
+	m_max = ( m_entries == 0 ? value : std::max( m_max , value ) );
+	++m_entries;
+	m_sum += value;
+	m_sum2 += value * value;
+	const int bin = magnitudeBin( std::fabs( value ) );
+	if ( bin < 0 )
+	{
+		m_zero += 1.0;
+	}
+	else if ( bin == kNSignedBins )
+	{
+		( value < 0 ? m_underflow : m_overflow ) += 1.0;
+	}
+	else
+	{
+		( value < 0 ? m_negative : m_positive )[ bin ] += 1.0;
+	}
+}
+
+void StreamingHistogram::merge( const StreamingHistogram &other )
+{
+	if ( other.m_entries > 0 )
+	{
+		m_min = ( m_entries == 0 ? other.m_min : std::min( m_min , other.m_min ) );
+		m_max = ( m_entries == 0 ? other.m_max : std::max( m_max , other.m_max ) );
+	}
+	for ( int i_bin = 0 ; i_bin < kNSignedBins ; ++i_bin )
+	{
+		m_negative[ i_bin ] += other.m_negative[ i_bin ];
+		m_positive[ i_bin ] += other.m_positive[ i_bin ];
+	}
+	m_zero += other.m_zero;
+	m_underflow += other.m_underflow;
+	m_overflow += other.m_overflow;
+	m_entries += other.m_entries;
+	m_nInvalid += other.m_nInvalid;
+	m_sum += other.m_sum;
+	m_sum2 += other.m_sum2;
+}
+
+void StreamingHistogram::getState( double *state ) const
+{
+	std::copy( m_negative.begin() , m_negative.end() , state );
+	std::copy( m_positive.begin() , m_positive.end() , state + kNSignedBins );
+	double *scalars = state + 2 * kNSignedBins;
+	scalars[ 0 ] = m_zero;
+	scalars[ 1 ] = m_underflow;
+	scalars[ 2 ] = m_overflow;
+	scalars[ 3 ] = m_entries;
+	scalars[ 4 ] = m_nInvalid;
+	scalars[ 5 ] = m_sum;
+	scalars[ 6 ] = m_sum2;
+	scalars[ 7 ] = m_min;
+	scalars[ 8 ] = m_max;
+}
+
+void StreamingHistogram::setState( const double *state )
+{
+	std::copy( state , state + kNSignedBins , m_negative.begin() );
+	std::copy( state + kNSignedBins , state + 2 * kNSignedBins , m_positive.begin() );
+	const double *scalars = state + 2 * kNSignedBins;
+	m_zero = scalars[ 0 ];
+	m_underflow = scalars[ 1 ];
+	m_overflow = scalars[ 2 ];
+	m_entries = static_cast<long long>( scalars[ 3 ] );
+	m_nInvalid = static_cast<long long>( scalars[ 4 ] );
+	m_sum = scalars[ 5 ];
+	m_sum2 = scalars[ 6 ];
+	m_min = scalars[ 7 ];
+	m_max = scalars[ 8 ];
+}
+
+template <class Visitor> void StreamingHistogram::forEachBin( Visitor visit ) const
+{
+	const double largest = std::ldexp( 1.0 , kMaxExponent );
+	const double smallest = std::ldexp( 1.0 , kMinExponent );
+	if ( m_underflow > 0.0 ) visit( m_min , -largest , m_underflow );
+	for ( int i_bin = kNSignedBins - 1 ; i_bin >= 0 ; --i_bin )
+	{
+		if ( m_negative[ i_bin ] > 0.0 ) visit( -magnitudeBinLowEdge( i_bin + 1 ) , -magnitudeBinLowEdge( i_bin ) , m_negative[ i_bin ] );
+	}
+	if ( m_zero > 0.0 ) visit( -smallest , smallest , m_zero );
+	for ( int i_bin = 0 ; i_bin < kNSignedBins ; ++i_bin )
+	{
+		if ( m_positive[ i_bin ] > 0.0 ) visit( magnitudeBinLowEdge( i_bin ) , magnitudeBinLowEdge( i_bin + 1 ) , m_positive[ i_bin ] );
+	}
+	if ( m_overflow > 0.0 ) visit( largest , m_max , m_overflow );
+}
+
+double StreamingHistogram::mean() const
+{
+	return ( m_entries > 0 ? m_sum / m_entries : 0.0 );
+}
+
+double StreamingHistogram::rms() const
+{
+	if ( m_entries == 0 ) return 0.0;
+	const double mean = m_sum / m_entries;
+	return std::sqrt( std::max( m_sum2 / m_entries - mean * mean , 0.0 ) );
+}
+
+double StreamingHistogram::quantile( double q ) const
+{
+	if ( m_entries == 0 ) return 0.0;
+	const double target = std::min( std::max( q , 0.0 ) , 1.0 ) * m_entries;
+	double cumulative = 0.0;
+	double value = m_max;
+	bool found = false;
+	forEachBin( [ & ]( double low , double high , double count )
+	{
+		if ( found ) return;
+		if ( cumulative + count >= target )
+		{
+			value = low + ( high - low ) * ( target - cumulative ) / count;
+			found = true;
+		}
+		cumulative += count;
+	} );
+	return std::min( std::max( value , m_min ) , m_max );
+}
+
+TH1F *StreamingHistogram::makeTH1F( const std::string &name , const std::string &title , int maxBins ) const
+{
+	maxBins = std::max( maxBins , 1 );
+	double rangeLow = quantile( 0.001 );
+	double rangeHigh = quantile( 0.999 );
+	if ( !( rangeHigh > rangeLow ) )
+	{
+		rangeLow -= 1.0;
+		rangeHigh += 1.0;
+	}
+
+	// round bin width of 1, 2 or 5 times a power of ten
+	const double rawWidth = ( rangeHigh - rangeLow ) / maxBins;
+	const double decade = std::pow( 10.0 , std::floor( std::log10( rawWidth ) ) );
+	const double steps[ 4 ]{ 1.0 , 2.0 , 5.0 , 10.0 };
+	double width = 0.0;
+	double low = 0.0;
+	int nBins = 0;
+	for ( int i_step = 0 ; i_step < 8 ; ++i_step )
+	{
+		width = steps[ i_step % 4 ] * decade * ( i_step < 4 ? 1.0 : 10.0 );
+		if ( width < rawWidth ) continue;
+		low = std::floor( rangeLow / width ) * width;
+		nBins = static_cast<int>( std::ceil( ( rangeHigh - low ) / width ) );
+		if ( nBins <= maxBins ) break;
+	}
+	nBins = std::min( std::max( nBins , 1 ) , maxBins );
+	const double high = low + nBins * width;
+
+	// spread every internal bin uniformly over the output bins it overlaps
+	std::vector<double> contents( nBins + 2 , 0.0 );
+	forEachBin( [ & ]( double binLow , double binHigh , double count )
+	{
+		if ( !( binHigh > binLow ) )
+		{
+			const int outputBin = ( binLow < low ? 0 : binLow >= high ? nBins + 1 : 1 + static_cast<int>( ( binLow - low ) / width ) );
+			contents[ std::min( outputBin , nBins + 1 ) ] += count;
+			return;
+		}
+		const double density = count / ( binHigh - binLow );
+		if ( binLow < low ) contents[ 0 ] += density * ( std::min( binHigh , low ) - binLow );
+		if ( binHigh > high ) contents[ nBins + 1 ] += density * ( binHigh - std::max( binLow , high ) );
+		const double overlapLow = std::max( binLow , low );
+		const double overlapHigh = std::min( binHigh , high );
+		if ( overlapHigh <= overlapLow ) return;
+		const int firstBin = std::min( static_cast<int>( ( overlapLow - low ) / width ) , nBins - 1 );
+		const int lastBin = std::min( static_cast<int>( ( overlapHigh - low ) / width ) , nBins - 1 );
+		for ( int i_bin = firstBin ; i_bin <= lastBin ; ++i_bin )
+		{
+			const double edgeLow = std::max( overlapLow , low + i_bin * width );
+			const double edgeHigh = std::min( overlapHigh , low + ( i_bin + 1 ) * width );
+			if ( edgeHigh > edgeLow ) contents[ i_bin + 1 ] += density * ( edgeHigh - edgeLow );
+		}
+	} );
+
+	TH1F *histogram = new TH1F( name.c_str() , title.c_str() , nBins , low , high );
+	for ( int i_bin = 0 ; i_bin < nBins + 2 ; ++i_bin ) histogram->SetBinContent( i_bin , contents[ i_bin ] );
+
+	// statistics of all entries, not only of the binned range
+	double stats[ 4 ]{ static_cast<double>( m_entries ) , static_cast<double>( m_entries ) , m_sum , m_sum2 };
+	histogram->PutStats( stats );
+	histogram->SetEntries( m_entries );
+	return histogram;
+}
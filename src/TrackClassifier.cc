@@ -0,0 +1,98 @@
+#include "TrackClassifier.h"
+#include <algorithm>
+
+void TrackClassifier::setSpecies( const std::vector<Species> &species , double eB )
+{
+	m_species = species;
+	m_eB = eB;
+	m_collections.assign( m_species.size() , NULL );
+	m_speciesEnergy.assign( m_species.size() , 0.0 );
+	m_speciesTracks.assign( m_species.size() , 0 );
+}
+
+int TrackClassifier::findSpecies( int pdg ) const
+{
+	for ( unsigned int i_species = 0 ; i_species < m_species.size() ; ++i_species )
+	{
+		if ( m_species[ i_species ].pdg == pdg ) return i_species;
+	}
+	return -1;
+}
+
+void TrackClassifier::resolve( EVENT::LCEvent *pLCEvent , const std::vector<std::string> &collectionNames )
+{
+	for ( unsigned int i_species = 1 ; i_species < m_species.size() ; ++i_species )
+	{
+		const std::string &collectionName = m_species[ i_species ].collectionName;
+		const bool found = std::find( collectionNames.begin() , collectionNames.end() , collectionName ) != collectionNames.end();
+		m_collections[ i_species ] = ( found ? pLCEvent->getCollection( collectionName ) : NULL );
+	}
+}
+
+std::string TrackClassifier::missingCollections() const
+{
+	std::string missing{};
+	for ( unsigned int i_species = 1 ; i_species < m_species.size() ; ++i_species )
+	{
+		if ( m_collections[ i_species ] != NULL ) continue;
+		if ( !missing.empty() ) missing += ", ";
+		missing += m_species[ i_species ].collectionName;
+	}
+	return missing;
+}
+
+void TrackClassifier::indexTracks()
+{
+	// position in the index is species - 1
+	m_indexedCollections.assign( m_collections.begin() + std::min<std::size_t>( 1 , m_collections.size() ) , m_collections.end() );
+	m_trackIndex.build( m_indexedCollections );
+}
+
+void TrackClassifier::clearTracks()
+{
+	m_trackSpecies.clear();
+	m_momenta.clear();
+}
+
+void TrackClassifier::addTracks( const EVENT::TrackVec &tracks )
+{
+	for ( const EVENT::Track *track : tracks )
+	{
+		const int species = classify( track );
+		m_trackSpecies.push_back( species );
+		m_momenta.addTrack( track->getPhi() , track->getOmega() , track->getTanLambda() , m_species[ species ].mass );
+	}
+}
+
+void TrackClassifier::addCollectionTracks( int i_species , int first , int nTracks )
+{
+	EVENT::LCCollection *trackCollection = m_collections[ i_species ];
+	for ( int i_trk = first ; i_trk < first + nTracks ; ++i_trk )
+	{
+		const EVENT::Track *track = dynamic_cast<EVENT::Track*>( trackCollection->getElementAt( i_trk ) );
+		if ( track == NULL ) continue;
+		m_trackSpecies.push_back( i_species );
+		m_momenta.addTrack( track->getPhi() , track->getOmega() , track->getTanLambda() , m_species[ i_species ].mass );
+	}
+}
+
+void TrackClassifier::computeEnergies()
+{
+	if ( m_vectorized )
+	{
+		m_momenta.compute( m_eB );
+	}
+	else
+	{
+		m_momenta.computeReference( m_eB );
+	}
+	const unsigned int nTRKs = m_trackSpecies.size();
+	const std::vector<double> &trackEnergy = m_momenta.components( TrackMomentumBatch::kE );
+	std::fill( m_speciesEnergy.begin() , m_speciesEnergy.end() , 0.0 );
+	std::fill( m_speciesTracks.begin() , m_speciesTracks.end() , 0 );
+	for ( unsigned int i_trk = 0 ; i_trk < nTRKs ; ++i_trk )
+	{
+		m_speciesEnergy[ m_trackSpecies[ i_trk ] ] += trackEnergy[ i_trk ];
+		++m_speciesTracks[ m_trackSpecies[ i_trk ] ];
+	}
+}
@@ -0,0 +1,36 @@
+#include "TrackIndex.h"
+
+void TrackIndex::build( EVENT::LCCollection *trackCollection )
+{
+	unsigned int nTRKs = ( trackCollection != NULL ? trackCollection->getNumberOfElements() : 0 );
+	m_index.reserve( nTRKs );
+	for ( unsigned int i_trk = 0 ; i_trk < nTRKs ; ++i_trk )
+	{
+		const EVENT::Track *track = dynamic_cast<EVENT::Track*>( trackCollection->getElementAt( i_trk ) );
+
+		// same track listed twice: keep the last index, as the linear scan did
+		if ( track != NULL ) m_index.insert( track , i_trk );
+	}
+}
+
+void TrackIndex::build( const std::vector<EVENT::LCCollection*> &trackCollections )
+{
+	std::size_t nTRKs = 0;
+	for ( EVENT::LCCollection *trackCollection : trackCollections )
+	{
+		if ( trackCollection != NULL ) nTRKs += trackCollection->getNumberOfElements();
+	}
+	m_index.reserve( nTRKs );
+
+	// inserted from the last collection to the first, so a track listed twice keeps the first position
+	for ( int i_col = static_cast<int>( trackCollections.size() ) - 1 ; i_col >= 0 ; --i_col )
+	{
+		EVENT::LCCollection *trackCollection = trackCollections[ i_col ];
+		if ( trackCollection == NULL ) continue;
+		for ( int i_trk = 0 ; i_trk < trackCollection->getNumberOfElements() ; ++i_trk )
+		{
+			const EVENT::Track *track = dynamic_cast<EVENT::Track*>( trackCollection->getElementAt( i_trk ) );
+			if ( track != NULL ) m_index.insert( track , i_col );
+		}
+	}
+}
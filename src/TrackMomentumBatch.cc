@@ -0,0 +1,99 @@
+#include "TrackMomentumBatch.h"
+#include <cmath>
+
+void TrackMomentumBatch::clear()
+{
+	m_phi.clear();
+	m_omega.clear();
+	m_tanLambda.clear();
+	m_mass.clear();
+	for ( std::vector<double> &fourMomenta : m_fourMomenta ) fourMomenta.clear();
+}
+
+namespace
+{
+	// separate function, so that the compiler takes the arrays as not aliased instead of checking it at run time
+	void fourMomenta( std::size_t nTRKs , double eB , const double *__restrict sinPhi , const double *__restrict cosPhi , const double *__restrict omega , const double *__restrict tanLambda , const double *__restrict mass ,
+				double *__restrict px , double *__restrict py , double *__restrict pz , double *__restrict E )
+	{
+		for ( std::size_t i_trk = 0 ; i_trk < nTRKs ; ++i_trk )
+		{
+			const double pT = eB / std::fabs( omega[ i_trk ] );
+			px[ i_trk ] = pT * cosPhi[ i_trk ];
+			py[ i_trk ] = pT * sinPhi[ i_trk ];
+			pz[ i_trk ] = pT * tanLambda[ i_trk ];
+			E[ i_trk ] = std::sqrt( mass[ i_trk ] * mass[ i_trk ] + px[ i_trk ] * px[ i_trk ] + py[ i_trk ] * py[ i_trk ] + pz[ i_trk ] * pz[ i_trk ] );
+		}
+	}
+}
+
+void TrackMomentumBatch::sinCos( std::size_t n , const double *__restrict x , double *__restrict sinX , double *__restrict cosX )
+{
+	// Cephes sin / cos: reduction to [ -pi/4 , pi/4 ] by the nearest even multiple of pi/4 in three parts,
+	// then both minimax polynomials and a branch-free choice of polynomial and sign from the octant
+	const double fourOverPi = 1.27323954473516268615;
+	const double DP1 = 7.85398125648498535156E-1;
+	const double DP2 = 3.77489470793079817668E-8;
+	const double DP3 = 2.69515142907905952645E-15;
+	const double S0 = 1.58962301576546568060E-10;
+	const double S1 = -2.50507477628578072866E-8;
+	const double S2 = 2.75573136213857245213E-6;
+	const double S3 = -1.98412698295895385996E-4;
+	const double S4 = 8.33333333332211858878E-3;
+	const double S5 = -1.66666666666666307295E-1;
+	const double C0 = -1.13585365213876817300E-11;
+	const double C1 = 2.08757008419747316778E-9;
+	const double C2 = -2.75573141792967388112E-7;
+	const double C3 = 2.48015872888517045348E-5;
+	const double C4 = -1.38888888888730564116E-3;
+	const double C5 = 4.16666666666665929218E-2;
+	for ( std::size_t i = 0 ; i < n ; ++i )
+	{
+		const double ax = std::fabs( x[ i ] );
+		int octant = static_cast<int>( ax * fourOverPi );
+		octant += ( octant & 1 );
+		const double y = octant;
+		const double z = ( ( ax - y * DP1 ) - y * DP2 ) - y * DP3;
+		const double zz = z * z;
+		const double polySin = z + z * zz * ( ( ( ( ( S0 * zz + S1 ) * zz + S2 ) * zz + S3 ) * zz + S4 ) * zz + S5 );
+		const double polyCos = 1.0 - 0.5 * zz + zz * zz * ( ( ( ( ( C0 * zz + C1 ) * zz + C2 ) * zz + C3 ) * zz + C4 ) * zz + C5 );
+
+		// octant is 0, 2, 4 or 6 modulo 8: 2 and 6 swap sin and cos, 4 and 6 flip sin, 2 and 4 flip cos
+		const int swap = octant & 2;
+		const int flipSin = octant & 4;
+		const int flipCos = ( octant + 2 ) & 4;
+		const double s = ( swap ? polyCos : polySin );
+		const double c = ( swap ? polySin : polyCos );
+		const double signedS = ( x[ i ] < 0.0 ? -s : s );
+		sinX[ i ] = ( flipSin ? -signedS : signedS );
+		cosX[ i ] = ( flipCos ? -c : c );
+	}
+}
+
+void TrackMomentumBatch::compute( double eB )
+{
+	const std::size_t nTRKs = size();
+	for ( std::vector<double> &fourMomenta : m_fourMomenta ) fourMomenta.resize( nTRKs );
+	m_sinPhi.resize( nTRKs );
+	m_cosPhi.resize( nTRKs );
+	sinCos( nTRKs , m_phi.data() , m_sinPhi.data() , m_cosPhi.data() );
+
+	fourMomenta( nTRKs , eB , m_sinPhi.data() , m_cosPhi.data() , m_omega.data() , m_tanLambda.data() , m_mass.data() , m_fourMomenta[ kPx ].data() , m_fourMomenta[ kPy ].data() , m_fourMomenta[ kPz ].data() , m_fourMomenta[ kE ].data() );
+}
+
+void TrackMomentumBatch::computeReference( double eB )
+{
+	const std::size_t nTRKs = size();
+	for ( std::vector<double> &fourMomenta : m_fourMomenta ) fourMomenta.resize( nTRKs );
+	for ( std::size_t i_trk = 0 ; i_trk < nTRKs ; ++i_trk )
+	{
+		const double pT = eB / std::fabs( m_omega[ i_trk ] );
+		const double px = pT * std::cos( m_phi[ i_trk ] );
+		const double py = pT * std::sin( m_phi[ i_trk ] );
+		const double pz = pT * m_tanLambda[ i_trk ];
+		m_fourMomenta[ kPx ][ i_trk ] = px;
+		m_fourMomenta[ kPy ][ i_trk ] = py;
+		m_fourMomenta[ kPz ][ i_trk ] = pz;
+		m_fourMomenta[ kE ][ i_trk ] = std::sqrt( std::pow( m_mass[ i_trk ] , 2 ) + px * px + py * py + pz * pz );
+	}
+}
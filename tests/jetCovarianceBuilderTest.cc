@@ -0,0 +1,270 @@
+/*
+* Test of JetCovarianceBuilder: the ( px , py , pz , E ) covariance that finish() propagates from the helix
+* covariances of the tracks, J V J^T, is compared with the sample covariance of the jet four-momenta computed
+* from helix parameters drawn from those covariances. Tracks of both charges, of low and high transverse
+* momentum and with correlated ( phi , omega , tanLambda ) are checked alone and together with a neutral PFO;
+* a track without covariance must add its four-momentum only.
+*
+* usage: jetCovarianceBuilderTest [nSamples]
+*/
+#include "JetCovarianceBuilder.h"
+#include "TrackMomentumBatch.h"
+#include <IMPL/ReconstructedParticleImpl.h>
+#include <IMPL/TrackImpl.h>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// B = 3.5 T
+	const double eB = 3.5 * 2.99792458e-4;
+
+	// row and column of the lower triangle elements of a 4x4 matrix, ReconstructedParticle::getCovMatrix() order
+	const int kRow[ 10 ]{ 0 , 1 , 1 , 2 , 2 , 2 , 3 , 3 , 3 , 3 };
+	const int kColumn[ 10 ]{ 0 , 0 , 1 , 0 , 1 , 2 , 0 , 1 , 2 , 3 };
+
+	int nFailures = 0;
+
+	void check( bool condition , const std::string &what )
+	{
+		if ( condition ) return;
+		++nFailures;
+		std::cout << "FAILED: " << what << std::endl;
+	}
+
+	struct HelixTrack
+	{
+		double				phi;
+		double				omega;
+		double				tanLambda;
+		double				mass;
+		double				sigmaPhi;
+		double				sigmaOmega;
+		double				sigmaTanLambda;
+		double				rhoPhiOmega;
+		double				rhoPhiTanLambda;
+		double				rhoOmegaTanLambda;
+	};
+
+	void fourMomentum( double phi , double omega , double tanLambda , double mass , double *p4 )
+	{
+		const double pt = eB / std::abs( omega );
+		p4[ 0 ] = pt * std::cos( phi );
+		p4[ 1 ] = pt * std::sin( phi );
+		p4[ 2 ] = pt * tanLambda;
+		p4[ 3 ] = std::sqrt( pt * pt * ( 1.0 + tanLambda * tanLambda ) + mass * mass );
+	}
+
+	/*
+	* ( phi , omega , tanLambda ) covariance of the track
+	*/
+	void helixCovariance( const HelixTrack &track , double covariance[ 3 ][ 3 ] )
+	{
+		const double sigma[ 3 ]{ track.sigmaPhi , track.sigmaOmega , track.sigmaTanLambda };
+		const double rho[ 3 ][ 3 ]{	{ 1.0 , track.rhoPhiOmega , track.rhoPhiTanLambda } ,
+						{ track.rhoPhiOmega , 1.0 , track.rhoOmegaTanLambda } ,
+						{ track.rhoPhiTanLambda , track.rhoOmegaTanLambda , 1.0 } };
+		for ( int i = 0 ; i < 3 ; ++i )
+		{
+			for ( int j = 0 ; j < 3 ; ++j ) covariance[ i ][ j ] = rho[ i ][ j ] * sigma[ i ] * sigma[ j ];
+		}
+	}
+
+	/*
+	* LCIO track with the lower triangle of the ( d0 , phi , omega , z0 , tanLambda ) covariance
+	*/
+	std::unique_ptr<IMPL::TrackImpl> makeTrack( const HelixTrack &helixTrack , bool withCovariance )
+	{
+		std::unique_ptr<IMPL::TrackImpl> track( new IMPL::TrackImpl );
+		track->setPhi( helixTrack.phi );
+		track->setOmega( helixTrack.omega );
+		track->setTanLambda( helixTrack.tanLambda );
+		if ( !withCovariance ) return track;
+		double covariance[ 3 ][ 3 ];
+		helixCovariance( helixTrack , covariance );
+		float covMatrix[ 15 ]{};
+		covMatrix[ 0 ] = 1e-4;
+		covMatrix[ 2 ] = covariance[ 0 ][ 0 ];
+		covMatrix[ 4 ] = covariance[ 1 ][ 0 ];
+		covMatrix[ 5 ] = covariance[ 1 ][ 1 ];
+		covMatrix[ 9 ] = 1e-4;
+		covMatrix[ 11 ] = covariance[ 2 ][ 0 ];
+		covMatrix[ 12 ] = covariance[ 2 ][ 1 ];
+		covMatrix[ 14 ] = covariance[ 2 ][ 2 ];
+		track->setCovMatrix( covMatrix );
+		return track;
+	}
+
+	/*
+	* Builds the jet of the tracks ( one PFO each ) and the neutral PFO, if any, and compares four-momentum and
+	* covariance with the nominal four-momentum and the sample covariance of nSamples drawn jets
+	*/
+	void checkJet( const std::vector<HelixTrack> &helixTracks , const IMPL::ReconstructedParticleImpl *neutral , int nSamples , std::mt19937_64 &generator , const std::string &label )
+	{
+		std::vector<std::unique_ptr<IMPL::TrackImpl>> tracks;
+		std::vector<std::unique_ptr<IMPL::ReconstructedParticleImpl>> pfos;
+		JetCovarianceBuilder jetCovarianceBuilder;
+		TrackMomentumBatch momenta;
+		jetCovarianceBuilder.clear();
+		momenta.clear();
+		for ( const HelixTrack &helixTrack : helixTracks )
+		{
+			tracks.push_back( makeTrack( helixTrack , true ) );
+			pfos.emplace_back( new IMPL::ReconstructedParticleImpl );
+			pfos.back()->addTrack( tracks.back().get() );
+			jetCovarianceBuilder.addParticle( pfos.back().get() );
+			momenta.addTrack( helixTrack.phi , helixTrack.omega , helixTrack.tanLambda , helixTrack.mass );
+		}
+		if ( neutral != NULL ) jetCovarianceBuilder.addParticle( neutral );
+		momenta.computeReference( eB );
+		jetCovarianceBuilder.finish( momenta );
+		check( jetCovarianceBuilder.nTracks() == helixTracks.size() && jetCovarianceBuilder.nNeutrals() == ( neutral != NULL ? 1u : 0u ) , label + ": particle counts" );
+
+		// the neutral PFO is not sampled, its covariance is added to the sample covariance of the tracks
+		double trackNominal[ 4 ]{};
+		double nominal[ 4 ]{};
+		double neutralCovariance[ 4 ][ 4 ]{};
+		if ( neutral != NULL )
+		{
+			for ( int i = 0 ; i < 3 ; ++i ) nominal[ i ] += neutral->getMomentum()[ i ];
+			nominal[ 3 ] += neutral->getEnergy();
+			for ( int i_element = 0 ; i_element < 10 ; ++i_element )
+			{
+				neutralCovariance[ kRow[ i_element ] ][ kColumn[ i_element ] ] = neutral->getCovMatrix()[ i_element ];
+				neutralCovariance[ kColumn[ i_element ] ][ kRow[ i_element ] ] = neutral->getCovMatrix()[ i_element ];
+			}
+		}
+		std::vector<std::array<double,9>> choleskyFactors;
+		for ( const HelixTrack &helixTrack : helixTracks )
+		{
+			double p4[ 4 ];
+			fourMomentum( helixTrack.phi , helixTrack.omega , helixTrack.tanLambda , helixTrack.mass , p4 );
+			for ( int i = 0 ; i < 4 ; ++i )
+			{
+				trackNominal[ i ] += p4[ i ];
+				nominal[ i ] += p4[ i ];
+			}
+			double covariance[ 3 ][ 3 ];
+			helixCovariance( helixTrack , covariance );
+			std::array<double,9> factor{};
+			for ( int i = 0 ; i < 3 ; ++i )
+			{
+				for ( int j = 0 ; j <= i ; ++j )
+				{
+					double sum = covariance[ i ][ j ];
+					for ( int k = 0 ; k < j ; ++k ) sum -= factor[ 3 * i + k ] * factor[ 3 * j + k ];
+					factor[ 3 * i + j ] = ( i == j ? std::sqrt( sum ) : sum / factor[ 3 * j + j ] );
+				}
+			}
+			choleskyFactors.push_back( factor );
+		}
+		for ( int i = 0 ; i < 4 ; ++i )
+		{
+			check( std::abs( jetCovarianceBuilder.fourMomentum()[ i ] - nominal[ i ] ) <= 1e-9 * std::abs( nominal[ 3 ] ) , label + ": four-momentum component " + std::to_string( i ) );
+		}
+
+		std::normal_distribution<double> normal( 0.0 , 1.0 );
+		double mean[ 4 ]{};
+		double moments[ 4 ][ 4 ]{};
+		for ( int i_sample = 0 ; i_sample < nSamples ; ++i_sample )
+		{
+			double jet[ 4 ]{};
+			for ( std::size_t i_trk = 0 ; i_trk < helixTracks.size() ; ++i_trk )
+			{
+				const HelixTrack &helixTrack = helixTracks[ i_trk ];
+				const std::array<double,9> &factor = choleskyFactors[ i_trk ];
+				const double z[ 3 ]{ normal( generator ) , normal( generator ) , normal( generator ) };
+				double shift[ 3 ]{};
+				for ( int i = 0 ; i < 3 ; ++i )
+				{
+					for ( int k = 0 ; k <= i ; ++k ) shift[ i ] += factor[ 3 * i + k ] * z[ k ];
+				}
+				double p4[ 4 ];
+				fourMomentum( helixTrack.phi + shift[ 0 ] , helixTrack.omega + shift[ 1 ] , helixTrack.tanLambda + shift[ 2 ] , helixTrack.mass , p4 );
+				for ( int i = 0 ; i < 4 ; ++i ) jet[ i ] += p4[ i ];
+			}
+
+			// moments about the nominal four-momentum of the tracks, which is close to the mean, keep the sums well conditioned
+			for ( int i = 0 ; i < 4 ; ++i )
+			{
+				jet[ i ] -= trackNominal[ i ];
+				mean[ i ] += jet[ i ];
+				for ( int j = 0 ; j <= i ; ++j ) moments[ i ][ j ] += jet[ i ] * jet[ j ];
+			}
+		}
+		for ( int i = 0 ; i < 4 ; ++i ) mean[ i ] /= nSamples;
+		double sampleCovariance[ 4 ][ 4 ]{};
+		for ( int i = 0 ; i < 4 ; ++i )
+		{
+			for ( int j = 0 ; j <= i ; ++j )
+			{
+				sampleCovariance[ i ][ j ] = moments[ i ][ j ] / nSamples - mean[ i ] * mean[ j ] + neutralCovariance[ i ][ j ];
+				sampleCovariance[ j ][ i ] = sampleCovariance[ i ][ j ];
+			}
+		}
+
+		// statistical error of a sample covariance ( V_ii V_jj + V_ij^2 ) / N, plus 0.2% of the scale for the
+		// second-order terms the linear propagation drops ( relative omega errors of at most 1% ) and the float storage
+		for ( int i_element = 0 ; i_element < 10 ; ++i_element )
+		{
+			const int row = kRow[ i_element ];
+			const int column = kColumn[ i_element ];
+			const double propagated = jetCovarianceBuilder.covMatrix()[ i_element ];
+			const double sample = sampleCovariance[ row ][ column ];
+			const double scale = std::sqrt( sampleCovariance[ row ][ row ] * sampleCovariance[ column ][ column ] );
+			const double tolerance = 4.0 * std::sqrt( ( scale * scale + sample * sample ) / nSamples ) + 0.002 * scale;
+			if ( std::abs( propagated - sample ) <= tolerance ) continue;
+			check( false , label + ": covariance element " + std::to_string( i_element ) + " propagated " + std::to_string( propagated ) + " , sampled " + std::to_string( sample ) );
+		}
+	}
+}
+
+int main( int argc , char **argv )
+{
+	const int nSamples = ( argc > 1 ? std::atoi( argv[ 1 ] ) : 1000000 );
+	std::mt19937_64 generator( 4711 );
+
+	// phi , omega , tanLambda , mass , sigmas of phi , omega , tanLambda , correlations phi-omega , phi-tanLambda , omega-tanLambda
+	const HelixTrack negativePion{ 0.7 , -1.0e-4 , 0.6 , 0.13957018 , 1e-3 , 1e-6 , 1e-3 , 0.3 , -0.2 , 0.4 };
+	const HelixTrack positiveKaon{ -2.5 , 2.0e-3 , 2.5 , 0.493677 , 3e-3 , 2e-5 , 2e-2 , -0.5 , 0.1 , -0.3 };
+	const HelixTrack proton{ 3.0 , -5.0e-4 , -0.2 , 0.938272088 , 5e-4 , 4e-6 , 2e-3 , 0.0 , 0.6 , 0.0 };
+
+	checkJet( { negativePion } , NULL , nSamples , generator , "high-momentum negative track" );
+	checkJet( { positiveKaon } , NULL , nSamples , generator , "low-momentum forward positive track" );
+
+	IMPL::ReconstructedParticleImpl photon;
+	const double photonMomentum[ 3 ]{ 3.0 , -4.0 , 1.0 };
+	photon.setMomentum( photonMomentum );
+	photon.setEnergy( std::sqrt( 26.0 ) );
+	const float photonCovMatrix[ 10 ]{ 0.04f , 0.01f , 0.05f , 0.0f , 0.0f , 0.02f , 0.03f , -0.02f , 0.005f , 0.06f };
+	photon.setCovMatrix( photonCovMatrix );
+	checkJet( { negativePion , positiveKaon , proton } , &photon , nSamples , generator , "three tracks and a photon" );
+
+	// a track without covariance adds its four-momentum but nothing to the covariance
+	std::unique_ptr<IMPL::TrackImpl> track = makeTrack( proton , false );
+	IMPL::ReconstructedParticleImpl pfo;
+	pfo.addTrack( track.get() );
+	JetCovarianceBuilder jetCovarianceBuilder;
+	jetCovarianceBuilder.clear();
+	jetCovarianceBuilder.addParticle( &pfo );
+	TrackMomentumBatch momenta;
+	momenta.clear();
+	momenta.addTrack( proton.phi , proton.omega , proton.tanLambda , proton.mass );
+	momenta.computeReference( eB );
+	jetCovarianceBuilder.finish( momenta );
+	double p4[ 4 ];
+	fourMomentum( proton.phi , proton.omega , proton.tanLambda , proton.mass , p4 );
+	bool zeroCovariance = true;
+	for ( int i_element = 0 ; i_element < 10 ; ++i_element ) zeroCovariance = zeroCovariance && jetCovarianceBuilder.covMatrix()[ i_element ] == 0.0f;
+	check( zeroCovariance , "track without covariance: zero covariance" );
+	check( std::abs( jetCovarianceBuilder.fourMomentum()[ 3 ] - p4[ 3 ] ) <= 1e-9 * p4[ 3 ] , "track without covariance: energy" );
+
+	std::cout << "jetCovarianceBuilderTest: " << ( nFailures == 0 ? "passed" : "FAILED" ) << " ( " << nFailures << " failures )" << std::endl;
+	return ( nFailures == 0 ? 0 : 1 );
+}
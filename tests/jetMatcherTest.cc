@@ -0,0 +1,185 @@
+/*
+* Test of JetMatcher: the assignments of the enumeration and of the Hungarian method are compared with
+* a brute-force search over all assignments for random configurations of 1 to 8 true and reco jets, including
+* more true than reco jets, where the unmatched true jets must get -1. Ties ( identical, opposite and
+* zero-momentum jets ) must still give a valid one-to-one assignment of maximal summed cosine.
+*
+* usage: jetMatcherTest [nConfigurations]
+*/
+#include "JetMatcher.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef std::vector<std::vector<double>> Momenta;
+
+	int nFailures = 0;
+
+	void check( bool condition , const std::string &what )
+	{
+		if ( condition ) return;
+		++nFailures;
+		std::cout << "FAILED: " << what << std::endl;
+	}
+
+	double cosine( const std::vector<double> &a , const std::vector<double> &b )
+	{
+		const double magnitudeA = std::sqrt( a[ 0 ] * a[ 0 ] + a[ 1 ] * a[ 1 ] + a[ 2 ] * a[ 2 ] );
+		const double magnitudeB = std::sqrt( b[ 0 ] * b[ 0 ] + b[ 1 ] * b[ 1 ] + b[ 2 ] * b[ 2 ] );
+		if ( magnitudeA == 0.0 || magnitudeB == 0.0 ) return 0.0;
+		return ( a[ 0 ] * b[ 0 ] + a[ 1 ] * b[ 1 ] + a[ 2 ] * b[ 2 ] ) / ( magnitudeA * magnitudeB );
+	}
+
+	/*
+	* Largest summed cosine of a one-to-one assignment of min( nTrue , nReco ) pairs, by trying all of them
+	*/
+	double bruteForceSum( const Momenta &trueJets , const Momenta &recoJets , std::size_t i_true , std::vector<char> &recoUsed , std::size_t nUnmatched )
+	{
+		if ( i_true == trueJets.size() ) return 0.0;
+		double best = -1e300;
+		if ( nUnmatched > 0 ) best = bruteForceSum( trueJets , recoJets , i_true + 1 , recoUsed , nUnmatched - 1 );
+		for ( std::size_t i_reco = 0 ; i_reco < recoJets.size() ; ++i_reco )
+		{
+			if ( recoUsed[ i_reco ] ) continue;
+			recoUsed[ i_reco ] = 1;
+			best = std::max( best , cosine( trueJets[ i_true ] , recoJets[ i_reco ] ) + bruteForceSum( trueJets , recoJets , i_true + 1 , recoUsed , nUnmatched ) );
+			recoUsed[ i_reco ] = 0;
+		}
+		return best;
+	}
+
+	/*
+	* Matches with enumeration up to maxEnumeratedJets reco jets and checks the assignment against the brute force
+	*/
+	void checkMatch( const Momenta &trueJets , const Momenta &recoJets , std::size_t maxEnumeratedJets , const std::string &label )
+	{
+		JetMatcher jetMatcher;
+		for ( const std::vector<double> &momentum : trueJets ) jetMatcher.addTrueJet( momentum.data() );
+		for ( const std::vector<double> &momentum : recoJets ) jetMatcher.addRecoJet( momentum.data() );
+		const std::vector<int> &recoJetIndices = jetMatcher.match( maxEnumeratedJets );
+
+		std::ostringstream what;
+		what << label << " ( " << trueJets.size() << " true , " << recoJets.size() << " reco jets , " << ( maxEnumeratedJets > 0 ? "enumeration" : "Hungarian method" ) << " )";
+		check( recoJetIndices.size() == trueJets.size() , what.str() + ": one entry per true jet" );
+		if ( recoJetIndices.size() != trueJets.size() ) return;
+
+		std::vector<char> recoUsed( recoJets.size() , 0 );
+		std::size_t nMatched = 0;
+		double sum = 0.0;
+		bool valid = true;
+		for ( std::size_t i_true = 0 ; i_true < trueJets.size() ; ++i_true )
+		{
+			const int i_reco = recoJetIndices[ i_true ];
+			if ( i_reco == -1 ) continue;
+			if ( i_reco < 0 || i_reco >= static_cast<int>( recoJets.size() ) || recoUsed[ i_reco ] )
+			{
+				valid = false;
+				continue;
+			}
+			recoUsed[ i_reco ] = 1;
+			++nMatched;
+			sum += cosine( trueJets[ i_true ] , recoJets[ i_reco ] );
+		}
+		check( valid , what.str() + ": every reco jet matched at most once" );
+		check( nMatched == std::min( trueJets.size() , recoJets.size() ) , what.str() + ": every true jet matched, -1 only for the true jets in excess" );
+
+		const std::size_t nUnmatched = ( trueJets.size() > recoJets.size() ? trueJets.size() - recoJets.size() : 0 );
+		std::fill( recoUsed.begin() , recoUsed.end() , 0 );
+		const double bestSum = bruteForceSum( trueJets , recoJets , 0 , recoUsed , nUnmatched );
+		check( std::abs( sum - bestSum ) < 1e-9 , what.str() + ": summed cosine is the brute-force maximum" );
+	}
+
+	void checkBothMethods( const Momenta &trueJets , const Momenta &recoJets , const std::string &label )
+	{
+		checkMatch( trueJets , recoJets , 8 , label );
+		checkMatch( trueJets , recoJets , 0 , label );
+	}
+
+	Momenta randomJets( std::mt19937_64 &generator , std::size_t nJets )
+	{
+		std::normal_distribution<double> component( 0.0 , 30.0 );
+		Momenta jets( nJets , std::vector<double>( 3 ) );
+		for ( std::vector<double> &momentum : jets )
+		{
+			for ( double &p : momentum ) p = component( generator );
+		}
+		return jets;
+	}
+}
+
+int main( int argc , char **argv )
+{
+	const int nConfigurations = ( argc > 1 ? std::atoi( argv[ 1 ] ) : 200 );
+	std::mt19937_64 generator( 20231 );
+
+	// random directions, balanced and unbalanced in both directions
+	for ( int i_config = 0 ; i_config < nConfigurations ; ++i_config )
+	{
+		for ( std::size_t nTrue = 1 ; nTrue <= 8 ; ++nTrue )
+		{
+			for ( std::size_t nReco = 1 ; nReco <= 8 ; ++nReco )
+			{
+				if ( i_config % 8 != 0 && nTrue != nReco ) continue;
+				checkBothMethods( randomJets( generator , nTrue ) , randomJets( generator , nReco ) , "random" );
+			}
+		}
+	}
+
+	// reco jets close to the true jets in shuffled order: the matching must undo the shuffle
+	for ( std::size_t nJets = 1 ; nJets <= 8 ; ++nJets )
+	{
+		const Momenta trueJets = randomJets( generator , nJets );
+		std::vector<int> order( nJets );
+		for ( std::size_t i_jet = 0 ; i_jet < nJets ; ++i_jet ) order[ i_jet ] = i_jet;
+		std::shuffle( order.begin() , order.end() , generator );
+		Momenta recoJets;
+		for ( int i_true : order ) recoJets.push_back( std::vector<double>{ trueJets[ i_true ][ 0 ] * 1.01 , trueJets[ i_true ][ 1 ] * 0.99 , trueJets[ i_true ][ 2 ] } );
+		for ( std::size_t maxEnumeratedJets : { std::size_t( 8 ) , std::size_t( 0 ) } )
+		{
+			JetMatcher jetMatcher;
+			for ( const std::vector<double> &momentum : trueJets ) jetMatcher.addTrueJet( momentum.data() );
+			for ( const std::vector<double> &momentum : recoJets ) jetMatcher.addRecoJet( momentum.data() );
+			const std::vector<int> &recoJetIndices = jetMatcher.match( maxEnumeratedJets );
+			bool inverse = true;
+			for ( std::size_t i_reco = 0 ; i_reco < nJets ; ++i_reco ) inverse = inverse && recoJetIndices[ order[ i_reco ] ] == static_cast<int>( i_reco );
+			check( inverse , "shuffled reco jets are matched back to their true jets" );
+		}
+	}
+
+	// ties and degenerate directions
+	const std::vector<double> x{ 1.0 , 0.0 , 0.0 };
+	const std::vector<double> minusX{ -1.0 , 0.0 , 0.0 };
+	const std::vector<double> y{ 0.0 , 2.0 , 0.0 };
+	const std::vector<double> zero{ 0.0 , 0.0 , 0.0 };
+	checkBothMethods( Momenta{ x , x , x } , Momenta{ x , x , x } , "identical jets" );
+	checkBothMethods( Momenta{ x , minusX } , Momenta{ x , x } , "one true jet opposite to both reco jets" );
+	checkBothMethods( Momenta{ x , y } , Momenta{ minusX , minusX , y } , "tied reco jets" );
+	checkBothMethods( Momenta{ zero , x } , Momenta{ x , zero } , "zero-momentum jets" );
+	checkBothMethods( Momenta{ zero , zero , zero } , Momenta{ zero , zero } , "only zero-momentum jets" );
+	checkBothMethods( Momenta{ x , x , y , y } , Momenta{ y , x } , "more true than reco jets with ties" );
+	checkBothMethods( Momenta{ x } , Momenta{} , "no reco jets" );
+	checkBothMethods( Momenta{} , Momenta{ x } , "no true jets" );
+
+	// matching again after clear() reuses the storage and forgets the previous event
+	JetMatcher jetMatcher;
+	jetMatcher.addTrueJet( x.data() );
+	jetMatcher.addRecoJet( y.data() );
+	jetMatcher.addRecoJet( x.data() );
+	jetMatcher.match();
+	jetMatcher.clear();
+	jetMatcher.addTrueJet( y.data() );
+	jetMatcher.addTrueJet( x.data() );
+	jetMatcher.addRecoJet( x.data() );
+	const std::vector<int> &recoJetIndices = jetMatcher.match();
+	check( recoJetIndices.size() == 2 && recoJetIndices[ 0 ] == -1 && recoJetIndices[ 1 ] == 0 , "match after clear()" );
+
+	std::cout << "jetMatcherTest: " << ( nFailures == 0 ? "passed" : "FAILED" ) << " ( " << nFailures << " failures )" << std::endl;
+	return ( nFailures == 0 ? 0 : 1 );
+}
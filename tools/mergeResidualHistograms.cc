@@ -0,0 +1,161 @@
+/*
+* Merges the partialResidualHistograms trees of JetErrorAnalysis jobs run with writePartialHistograms = true
+* and normalizes and fits the merged histograms once, as end() of a single job over all their events would.
+* The inputs are read one at a time and summed pairwise in a binary tree: a partial result of level n is
+* merged with the next one of the same level into one of level n + 1. Thousands of inputs need memory for
+* about log2( nInputs ) partial results only, and the rounding of the sums grows with the depth of the tree
+* instead of the number of inputs. The output holds the fitted histograms and the merged partial tree, so
+* outputs of several merges can be merged again.
+*
+* usage: mergeResidualHistograms [-o output.root] [-b maxBins] input.root ... [@fileList.txt ...]
+*/
+#include "GaussianCoreFitter.h"
+#include "PartialHistogramTree.h"
+#include "ResidualHistogramOutput.h"
+#include "ResidualObservables.h"
+#include "TF1.h"
+#include "TFile.h"
+#include "TH1F.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	typedef std::vector<PartialHistogramTree::Entry>	PartialResult;
+
+	/*
+	* Pending partial results, each of 2^level inputs, with strictly decreasing levels
+	*/
+	class PairwiseMerger
+	{
+		public:
+
+			void add( PartialResult partialResult )
+			{
+				int level = 0;
+				while ( !m_levels.empty() && m_levels.back().first == level )
+				{
+					PartialHistogramTree::merge( m_levels.back().second , partialResult );
+					partialResult = std::move( m_levels.back().second );
+					m_levels.pop_back();
+					++level;
+				}
+				m_levels.push_back( std::make_pair( level , std::move( partialResult ) ) );
+			}
+
+			PartialResult result()
+			{
+				PartialResult merged;
+				while ( !m_levels.empty() )
+				{
+					PartialHistogramTree::merge( m_levels.back().second , merged );
+					merged = std::move( m_levels.back().second );
+					m_levels.pop_back();
+				}
+				return merged;
+			}
+
+		private:
+
+			std::vector<std::pair<int,PartialResult>>	m_levels{};
+	};
+
+	bool addInput( const std::string &fileName , PairwiseMerger &merger )
+	{
+		std::unique_ptr<TFile> file( TFile::Open( fileName.c_str() ) );
+		if ( !file || file->IsZombie() )
+		{
+			std::cerr << "cannot open " << fileName << std::endl;
+			return false;
+		}
+		PartialResult partialResult;
+		if ( !PartialHistogramTree::read( file.get() , partialResult ) )
+		{
+			std::cerr << "no " << PartialHistogramTree::treeName << " tree of this binning in " << fileName << std::endl;
+			return false;
+		}
+		file->Close();
+		merger.add( std::move( partialResult ) );
+		return true;
+	}
+}
+
+int main( int argc , char **argv )
+{
+	std::string outputName = "mergedResidualHistograms.root";
+	int maxBins = 0;
+	std::vector<std::string> inputNames;
+	for ( int i_arg = 1 ; i_arg < argc ; ++i_arg )
+	{
+		const std::string argument = argv[ i_arg ];
+		if ( argument == "-o" && i_arg + 1 < argc )
+		{
+			outputName = argv[ ++i_arg ];
+		}
+		else if ( argument == "-b" && i_arg + 1 < argc )
+		{
+			maxBins = std::atoi( argv[ ++i_arg ] );
+		}
+		else if ( argument[ 0 ] == '@' )
+		{
+			std::ifstream fileList( argument.substr( 1 ) );
+			std::string inputName;
+			while ( fileList >> inputName ) inputNames.push_back( inputName );
+		}
+		else
+		{
+			inputNames.push_back( argument );
+		}
+	}
+	if ( inputNames.empty() )
+	{
+		std::cerr << "usage: mergeResidualHistograms [-o output.root] [-b maxBins] input.root ... [@fileList.txt ...]" << std::endl;
+		return 1;
+	}
+
+	PairwiseMerger merger;
+	int nFailed = 0;
+	for ( const std::string &inputName : inputNames )
+	{
+		if ( !addInput( inputName , merger ) ) ++nFailed;
+	}
+	const PartialResult merged = merger.result();
+	std::cout << "merged " << inputNames.size() - nFailed << " of " << inputNames.size() << " inputs" << std::endl;
+
+	TFile output( outputName.c_str() , "RECREATE" );
+	for ( const PartialHistogramTree::Entry &entry : merged )
+	{
+		const bool knownObservable = ( entry.observable >= 0 && entry.observable < JetResidualBatch::kNResiduals );
+		const char *axisTitle = ( knownObservable ? residualObservables[ entry.observable ].axisTitle : "" );
+		TH1F *histogram = ResidualHistogramOutput::book( entry.histogram , entry.name , entry.title , axisTitle , ( maxBins > 0 ? maxBins : entry.maxBins ) );
+		ResidualHistogramOutput::normalize( histogram , entry.nJets , entry.colour , 1 , 1.0 , 1 );
+		if ( knownObservable && !residualObservables[ entry.observable ].fitGaussianCore )
+		{
+			const int nDegreesOfFreedom = residualObservables[ entry.observable ].nDegreesOfFreedom;
+			std::cout << entry.name << " : " << entry.nJets << " jets , mean chi2 / ndf = " << entry.histogram.mean() / nDegreesOfFreedom << " , ndf = " << nDegreesOfFreedom << std::endl;
+			ResidualHistogramOutput::formatAxes( histogram );
+			histogram->Write();
+			continue;
+		}
+		const GaussianCoreFitter::Result result = ResidualHistogramOutput::fitGaussianCore( histogram , -2.0 , 2.0 , 2.0 );
+		if ( result.valid )
+		{
+			histogram->GetFunction("gaus")->SetLineColor( entry.colour );
+			std::cout << entry.name << " : " << entry.nJets << " jets , mean = " << result.mean << " +- " << result.meanError << " , sigma = " << result.sigma << " +- " << result.sigmaError << std::endl;
+		}
+		else
+		{
+			std::cout << entry.name << " : " << entry.nJets << " jets , no Gaussian core found" << std::endl;
+		}
+		ResidualHistogramOutput::formatAxes( histogram );
+		histogram->Write();
+	}
+	PartialHistogramTree::write( &output , merged );
+	output.Close();
+	return ( nFailed > 0 ? 2 : 0 );
+}